@@ -2,6 +2,9 @@
 #include "paginator.h"
 #include "remove_duplicates.h"
 
+#include <chrono>
+#include <random>
+
 using namespace std;
 
 void AddDocument(SearchServer& search_server, int document_id, const string& document, DocumentStatus status,
@@ -14,6 +17,77 @@ void AddDocument(SearchServer& search_server, int document_id, const string& doc
     }
 }
 
+string GenerateWord(mt19937& generator) {
+    return "word"s + to_string(uniform_int_distribution<int>(0, 4999)(generator));
+}
+
+string JoinWords(const vector<string>& words) {
+    string document;
+    for (const string& word : words) {
+        document += word + " "s;
+    }
+    return document;
+}
+
+void BenchmarkRemoveDuplicates(int document_count) {
+    mt19937 generator(42);
+    SearchServer search_server("and with"s);
+    vector<string> words;
+    for (int document_id = 0; document_id < document_count; ++document_id) {
+        if (document_id % 4 == 3) {
+            shuffle(words.begin(), words.end(), generator);
+        }
+        else {
+            words.assign(uniform_int_distribution<int>(5, 40)(generator), {});
+            for (string& word : words) {
+                word = GenerateWord(generator);
+            }
+        }
+        search_server.AddDocument(document_id, JoinWords(words), DocumentStatus::ACTUAL, { 1 });
+    }
+    const auto start_time = chrono::steady_clock::now();
+    RemoveDuplicates(search_server);
+    const auto duration = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start_time);
+    cout << "RemoveDuplicates on "s << document_count << " documents: "s << document_count - search_server.GetDocumentCount()
+        << " removed in "s << duration.count() << " ms"s << endl;
+}
+
+// Every fourth document is the previous one with a word replaced and a word appended.
+void BenchmarkFindNearDuplicates(int document_count) {
+    mt19937 generator(7);
+    SearchServer search_server("and with"s);
+    vector<string> words;
+    for (int document_id = 0; document_id < document_count; ++document_id) {
+        if (document_id % 4 == 3) {
+            words[uniform_int_distribution<int>(0, words.size() - 1)(generator)] = GenerateWord(generator);
+            words.push_back(GenerateWord(generator));
+        }
+        else {
+            words.assign(uniform_int_distribution<int>(20, 40)(generator), {});
+            for (string& word : words) {
+                word = GenerateWord(generator);
+            }
+        }
+        search_server.AddDocument(document_id, JoinWords(words), DocumentStatus::ACTUAL, { 1 });
+    }
+    const auto start_time = chrono::steady_clock::now();
+    const auto clusters = FindNearDuplicates(search_server, { 0.8 });
+    const auto duration = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start_time);
+
+    vector<int> cluster_of(document_count, -1);
+    for (size_t i = 0; i < clusters.size(); ++i) {
+        for (const int document_id : clusters[i]) {
+            cluster_of[document_id] = i;
+        }
+    }
+    int found_count = 0;
+    for (int document_id = 3; document_id < document_count; document_id += 4) {
+        found_count += cluster_of[document_id] >= 0 && cluster_of[document_id] == cluster_of[document_id - 1];
+    }
+    cout << "FindNearDuplicates on "s << document_count << " documents: "s << clusters.size() << " clusters, "s
+        << found_count << " of "s << document_count / 4 << " edited copies found in "s << duration.count() << " ms"s << endl;
+}
+
 int main() {
     SearchServer search_server("and with"s);
 
@@ -41,7 +115,18 @@ int main() {
     //    ,   
     AddDocument(search_server, 9, "nasty rat with curly hair"s, DocumentStatus::ACTUAL, { 1, 2 });
 
+    for (const vector<int>& cluster : FindNearDuplicates(search_server)) {
+        cout << "Near duplicates:"s;
+        for (const int document_id : cluster) {
+            cout << " "s << document_id;
+        }
+        cout << endl;
+    }
+
     cout << "Before duplicates removed: "s << search_server.GetDocumentCount() << endl;
     RemoveDuplicates(search_server);
     cout << "After duplicates removed: "s << search_server.GetDocumentCount() << endl;
+
+    BenchmarkRemoveDuplicates(200000);
+    BenchmarkFindNearDuplicates(200000);
 }
\ No newline at end of file
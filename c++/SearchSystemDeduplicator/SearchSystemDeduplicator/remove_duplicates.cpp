@@ -1,29 +1,264 @@
 #include "remove_duplicates.h"
+
 #include <algorithm>
+#include <cstdint>
+#include <execution>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Fingerprint {
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    bool operator==(const Fingerprint& other) const {
+        return high == other.high && low == other.low;
+    }
+};
+
+uint64_t MixBits(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+// Two independent 64-bit hashes of the sorted word id sequence.
+Fingerprint ComputeFingerprint(const std::vector<int>& word_ids) {
+    Fingerprint fingerprint{ 0x9e3779b97f4a7c15ULL, MixBits(word_ids.size()) };
+    for (const int word_id : word_ids) {
+        fingerprint.high = MixBits(fingerprint.high ^ static_cast<uint32_t>(word_id));
+        fingerprint.low = MixBits(fingerprint.low + static_cast<uint32_t>(word_id) * 0xff51afd7ed558ccdULL);
+    }
+    return fingerprint;
+}
+
+// Open addressing with linear probing, sized once for every document. Slots with an
+// equal fingerprint are all kept, so a hash collision never merges two different documents.
+class FingerprintSet {
+public:
+    explicit FingerprintSet(size_t document_count) {
+        size_t capacity = 16;
+        while (capacity < document_count * 2) {
+            capacity *= 2;
+        }
+        slots_.resize(capacity);
+    }
+
+    // Returns the stored document that is_same accepts, or inserts document_id and returns -1.
+    template <typename IsSame>
+    int FindOrInsert(const Fingerprint& fingerprint, int document_id, IsSame is_same) {
+        const size_t mask = slots_.size() - 1;
+        for (size_t index = fingerprint.low & mask;; index = (index + 1) & mask) {
+            Slot& slot = slots_[index];
+            if (slot.document_id < 0) {
+                slot = { fingerprint, document_id };
+                return -1;
+            }
+            if (slot.fingerprint == fingerprint && is_same(slot.document_id)) {
+                return slot.document_id;
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        Fingerprint fingerprint;
+        int document_id = -1;
+    };
+
+    std::vector<Slot> slots_;
+};
+
+// Hash k of a word is a multiply-shift of its mixed id; the signature keeps each hash's minimum
+// over the document's words, so two signatures agree at k with probability equal to the Jaccard
+// similarity of the word sets.
+void ComputeMinHashSignature(const std::vector<int>& word_ids, const std::vector<uint64_t>& multipliers,
+    std::vector<uint32_t>& signature) {
+    signature.assign(multipliers.size(), UINT32_MAX);
+    for (const int word_id : word_ids) {
+        const uint64_t word_hash = MixBits(static_cast<uint32_t>(word_id));
+        for (size_t k = 0; k < multipliers.size(); ++k) {
+            signature[k] = std::min(signature[k], static_cast<uint32_t>((word_hash * multipliers[k]) >> 32));
+        }
+    }
+}
+
+double ComputeJaccard(const std::vector<int>& lhs, const std::vector<int>& rhs) {
+    size_t common_count = 0;
+    for (auto lhs_it = lhs.begin(), rhs_it = rhs.begin(); lhs_it != lhs.end() && rhs_it != rhs.end();) {
+        if (*lhs_it < *rhs_it) {
+            ++lhs_it;
+        }
+        else if (*rhs_it < *lhs_it) {
+            ++rhs_it;
+        }
+        else {
+            ++common_count;
+            ++lhs_it;
+            ++rhs_it;
+        }
+    }
+    return common_count * 1.0 / (lhs.size() + rhs.size() - common_count);
+}
+
+int FindRoot(std::vector<int>& parents, int index) {
+    while (parents[index] != index) {
+        parents[index] = parents[parents[index]];
+        index = parents[index];
+    }
+    return index;
+}
+
+} // namespace
 
 void RemoveDuplicates(SearchServer& search_server) {
+    const std::vector<int> document_ids(search_server.begin(), search_server.end());
+
+    std::vector<Fingerprint> fingerprints(document_ids.size());
+    std::transform(std::execution::par, document_ids.begin(), document_ids.end(), fingerprints.begin(),
+        [&search_server](int document_id) {
+            return ComputeFingerprint(search_server.GetDocumentWordIds(document_id));
+        });
 
+    // Ids come in ascending order, so the first document of each word set is the one kept.
     std::vector<int> documents_to_delete;
-    std::set<std::set<std::string>> unic_words_controller;
+    FingerprintSet seen(document_ids.size());
+    for (size_t i = 0; i < document_ids.size(); ++i) {
+        const std::vector<int>& word_ids = search_server.GetDocumentWordIds(document_ids[i]);
+        const int original_id = seen.FindOrInsert(fingerprints[i], document_ids[i], [&](int stored_id) {
+            return search_server.GetDocumentWordIds(stored_id) == word_ids;
+            });
+        if (original_id >= 0) {
+            documents_to_delete.push_back(document_ids[i]);
+        }
+    }
 
+    for (const int id_to_del : documents_to_delete) {
+        search_server.RemoveDocument(id_to_del);
+    }
+}
+
+std::vector<std::vector<int>> FindNearDuplicates(const SearchServer& search_server, const NearDuplicateOptions& options) {
+    using namespace std;
+    if (!(options.jaccard_threshold > 0.0 && options.jaccard_threshold <= 1.0)) {
+        throw invalid_argument("Jaccard threshold must be in (0, 1]"s);
+    }
+    if (options.band_count <= 0 || options.rows_per_band <= 0 || options.max_pairwise_bucket_size < 2) {
+        throw invalid_argument("Band count and rows per band must be positive, pairwise buckets hold at least two"s);
+    }
+    const size_t band_count = options.band_count;
+    const size_t rows_per_band = options.rows_per_band;
+
+    // Documents without words have no signature and are never near anything.
+    vector<int> document_ids;
     for (const int document_id : search_server) {
+        if (!search_server.GetDocumentWordIds(document_id).empty()) {
+            document_ids.push_back(document_id);
+        }
+    }
+    const size_t document_count = document_ids.size();
 
-        std::map<std::string, double> word_freqs = search_server.GetWordFrequencies(document_id);
-        std::set<std::string> words;
-        for (const auto& [word, freq] : word_freqs) {
-            words.insert(word);
+    vector<uint64_t> multipliers(band_count * rows_per_band);
+    for (size_t k = 0; k < multipliers.size(); ++k) {
+        multipliers[k] = MixBits(k + 1) | 1;
+    }
+
+    // band_keys[band * document_count + i] hashes the rows of that band in document i's signature.
+    vector<uint64_t> band_keys(band_count * document_count);
+    vector<size_t> indexes(document_count);
+    iota(indexes.begin(), indexes.end(), 0);
+    for_each(execution::par, indexes.begin(), indexes.end(), [&](size_t index) {
+        vector<uint32_t> signature;
+        ComputeMinHashSignature(search_server.GetDocumentWordIds(document_ids[index]), multipliers, signature);
+        for (size_t band = 0; band < band_count; ++band) {
+            uint64_t key = 0;
+            for (size_t row = 0; row < rows_per_band; ++row) {
+                key = MixBits(key ^ signature[band * rows_per_band + row]);
+            }
+            band_keys[band * document_count + index] = key;
         }
+        });
 
-        if (unic_words_controller.count(words) > 0) {
-            documents_to_delete.push_back(document_id);
-            continue;
+    // Entries of a bucket are in ascending index order, so every pair has its lower index first.
+    // A bucket too large to pair is linked to its first document and along its order instead,
+    // so a bucket of thousands of copies stays linear.
+    const size_t max_pairwise_bucket_size = options.max_pairwise_bucket_size;
+    vector<vector<pair<int, int>>> band_candidates(band_count);
+    vector<size_t> bands(band_count);
+    iota(bands.begin(), bands.end(), 0);
+    for_each(execution::par, bands.begin(), bands.end(), [&](size_t band) {
+        vector<pair<uint64_t, int>> entries(document_count);
+        for (size_t i = 0; i < document_count; ++i) {
+            entries[i] = { band_keys[band * document_count + i], static_cast<int>(i) };
+        }
+        sort(entries.begin(), entries.end());
+        for (size_t begin = 0, end = 0; begin < document_count; begin = end) {
+            while (end < document_count && entries[end].first == entries[begin].first) {
+                ++end;
+            }
+            if (end - begin <= max_pairwise_bucket_size) {
+                for (size_t i = begin; i < end; ++i) {
+                    for (size_t j = i + 1; j < end; ++j) {
+                        band_candidates[band].emplace_back(entries[i].second, entries[j].second);
+                    }
+                }
+                continue;
+            }
+            for (size_t i = begin + 1; i < end; ++i) {
+                band_candidates[band].emplace_back(entries[begin].second, entries[i].second);
+                if (i > begin + 1) {
+                    band_candidates[band].emplace_back(entries[i - 1].second, entries[i].second);
+                }
+            }
         }
+        });
 
-        unic_words_controller.insert(words);
+    vector<pair<int, int>> candidates;
+    for (vector<pair<int, int>>& pairs : band_candidates) {
+        candidates.insert(candidates.end(), pairs.begin(), pairs.end());
+        vector<pair<int, int>>().swap(pairs);
+    }
+    sort(execution::par, candidates.begin(), candidates.end());
+    candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+
+    vector<char> confirmed(candidates.size());
+    transform(execution::par, candidates.begin(), candidates.end(), confirmed.begin(), [&](const pair<int, int>& candidate) {
+        return ComputeJaccard(search_server.GetDocumentWordIds(document_ids[candidate.first]),
+            search_server.GetDocumentWordIds(document_ids[candidate.second])) >= options.jaccard_threshold;
+        });
 
+    // The lower index becomes the root, so a cluster's root is its lowest document id.
+    vector<int> parents(document_count);
+    iota(parents.begin(), parents.end(), 0);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (confirmed[i]) {
+            const int lhs_root = FindRoot(parents, candidates[i].first);
+            const int rhs_root = FindRoot(parents, candidates[i].second);
+            parents[max(lhs_root, rhs_root)] = min(lhs_root, rhs_root);
+        }
     }
 
-    for (const int id_to_del : documents_to_delete) {
-        search_server.RemoveDocument(id_to_del);
+    vector<int> cluster_sizes(document_count);
+    for (size_t i = 0; i < document_count; ++i) {
+        ++cluster_sizes[FindRoot(parents, i)];
+    }
+    vector<vector<int>> clusters;
+    vector<int> cluster_of_root(document_count, -1);
+    for (size_t i = 0; i < document_count; ++i) {
+        const int root = FindRoot(parents, i);
+        if (cluster_sizes[root] < 2) {
+            continue;
+        }
+        if (cluster_of_root[root] < 0) {
+            cluster_of_root[root] = clusters.size();
+            clusters.emplace_back();
+        }
+        clusters[cluster_of_root[root]].push_back(document_ids[i]);
     }
+    return clusters;
 }
\ No newline at end of file
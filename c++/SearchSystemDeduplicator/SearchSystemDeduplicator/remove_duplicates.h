@@ -2,4 +2,24 @@
 
 #include "search_server.h"
 
-void RemoveDuplicates(SearchServer& search_server);
\ No newline at end of file
+#include <vector>
+
+struct NearDuplicateOptions {
+    double jaccard_threshold = 0.8;
+    int band_count = 16;
+    int rows_per_band = 6;
+    // Buckets up to this size are paired exhaustively; larger ones are only chained, see below.
+    int max_pairwise_bucket_size = 64;
+};
+
+void RemoveDuplicates(SearchServer& search_server);
+
+// Groups documents whose word sets have Jaccard similarity of at least the threshold.
+// Candidates come from LSH over MinHash signatures of band_count * rows_per_band hashes
+// and are confirmed on the exact word sets; clusters are the connected components of
+// confirmed pairs. Each cluster is sorted by id and has at least two documents.
+// A band bucket larger than max_pairwise_bucket_size links each member only to the bucket's
+// first member and to its neighbour in hash order, so a document similar to just one member
+// in the middle of such a bucket is found only if another band or a chain of confirmed pairs
+// connects them: large buckets trade some recall for linear work.
+std::vector<std::vector<int>> FindNearDuplicates(const SearchServer& search_server, const NearDuplicateOptions& options = {});
\ No newline at end of file
@@ -16,6 +16,11 @@ void SearchServer::AddDocument(int document_id, const std::string& document, Doc
         word_to_document_freqs_[word][document_id] += inv_word_count;
         document_to_word_freqs_[document_id][word] += inv_word_count;
     }
+    std::vector<int>& word_ids = document_to_word_ids_[document_id];
+    for (const auto& [word, freq] : document_to_word_freqs_[document_id]) {
+        word_ids.push_back(word_ids_.emplace(word, static_cast<int>(word_ids_.size())).first->second);
+    }
+    sort(word_ids.begin(), word_ids.end());
     documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status });
     document_ids_.insert(document_id);
 }
@@ -42,6 +47,14 @@ std::set<int>::iterator SearchServer::end() {
     return document_ids_.end();
 }
 
+std::set<int>::const_iterator SearchServer::begin() const {
+    return document_ids_.begin();
+}
+
+std::set<int>::const_iterator SearchServer::end() const {
+    return document_ids_.end();
+}
+
 const std::map<std::string, double>& SearchServer::GetWordFrequencies(int document_id) const {
     static std::map<std::string, double> empty_word_freqs_;
     if (document_ids_.count(document_id) == 0) {
@@ -50,19 +63,25 @@ const std::map<std::string, double>& SearchServer::GetWordFrequencies(int docume
     return document_to_word_freqs_.at(document_id);
 }
 
+const std::vector<int>& SearchServer::GetDocumentWordIds(int document_id) const {
+    static const std::vector<int> empty_word_ids;
+    if (document_ids_.count(document_id) == 0) {
+        return empty_word_ids;
+    }
+    return document_to_word_ids_.at(document_id);
+}
+
 void SearchServer::RemoveDocument(int document_id) {
     if (document_ids_.count(document_id) == 0) {
         return;
     }
-    for (auto& [word, docs_freqs] : word_to_document_freqs_) {
-        if (docs_freqs.count(document_id) == 0) {
-            continue;
-        }
-        docs_freqs.erase(document_id);
+    for (const auto& [word, freq] : document_to_word_freqs_.at(document_id)) {
+        word_to_document_freqs_.at(word).erase(document_id);
     }
     document_ids_.erase(document_id);
     documents_.erase(document_id);
     document_to_word_freqs_.erase(document_id);
+    document_to_word_ids_.erase(document_id);
 }
 
 std::tuple<std::vector<std::string>, DocumentStatus> SearchServer::MatchDocument(const std::string& raw_query, int document_id) const {
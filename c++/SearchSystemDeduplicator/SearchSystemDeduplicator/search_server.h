@@ -30,8 +30,12 @@ public:
 
     std::set<int>::iterator begin();
     std::set<int>::iterator end();
+    std::set<int>::const_iterator begin() const;
+    std::set<int>::const_iterator end() const;
 
     const std::map<std::string, double>& GetWordFrequencies(int document_id) const;
+    // Sorted ids of the document's distinct words; equal word sets give equal vectors.
+    const std::vector<int>& GetDocumentWordIds(int document_id) const;
     void RemoveDocument(int document_id);
 
     std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::string& raw_query, int document_id) const;
@@ -46,6 +50,8 @@ private:
     std::map<int, DocumentData> documents_;
     std::set<int> document_ids_;
     std::map<int, std::map<std::string, double>> document_to_word_freqs_;
+    std::map<std::string, int> word_ids_;
+    std::map<int, std::vector<int>> document_to_word_ids_;
     bool IsStopWord(const std::string& word) const;
     static bool IsValidWord(const std::string& word);
     std::vector<std::string> SplitIntoWordsNoStop(const std::string& text) const;
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+inline size_t RoundUpToPowerOfTwo(size_t value) {
+    size_t power = 1;
+    while (power < value) {
+        power *= 2;
+    }
+    return power;
+}
+
+// Bounded lock-free ring for exactly one producer and one consumer thread. Each side keeps a
+// cached copy of the other side's index and rereads the shared one only when the cache says
+// the ring is full (empty), so in steady state the two threads do not share cache lines.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) : slots_(RoundUpToPowerOfTwo(capacity)), mask_(slots_.size() - 1) {
+    }
+
+    // Leaves value untouched and returns false when the queue is full.
+    bool TryPush(T&& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ == slots_.size()) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == slots_.size()) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& value) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return false;
+            }
+        }
+        value = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // A snapshot; exact only when both sides are idle.
+    size_t GetDepth() const {
+        const size_t head = head_.load(std::memory_order_acquire);
+        return tail_.load(std::memory_order_acquire) - head;
+    }
+
+    size_t GetCapacity() const {
+        return slots_.size();
+    }
+
+private:
+    std::vector<T> slots_;
+    const size_t mask_;
+    alignas(64) std::atomic<size_t> head_ = 0;
+    size_t cached_tail_ = 0;
+    alignas(64) std::atomic<size_t> tail_ = 0;
+    size_t cached_head_ = 0;
+};
+
+// Bounded lock-free queue for any number of producers and one consumer (Vyukov's array
+// queue). Every cell carries a sequence number that tells whose turn it is: producers claim
+// a position with one CAS and publish the cell by bumping its sequence.
+template <typename T>
+class MpscQueue {
+public:
+    explicit MpscQueue(size_t capacity) : capacity_(RoundUpToPowerOfTwo(capacity)), mask_(capacity_ - 1), cells_(std::make_unique<Cell[]>(capacity_)) {
+        for (size_t i = 0; i < capacity_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Leaves value untouched and returns false when the queue is full.
+    bool TryPush(T&& value) {
+        size_t position = enqueue_position_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells_[position & mask_];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+            if (difference == 0) {
+                if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (difference < 0) {
+                return false;
+            }
+            else {
+                position = enqueue_position_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& value) {
+        const size_t position = dequeue_position_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[position & mask_];
+        if (cell.sequence.load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+        value = std::move(cell.value);
+        cell.sequence.store(position + capacity_, std::memory_order_release);
+        dequeue_position_.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Claimed positions minus consumed ones, so it includes pushes still being written.
+    size_t GetDepth() const {
+        const size_t dequeue_position = dequeue_position_.load(std::memory_order_acquire);
+        return enqueue_position_.load(std::memory_order_acquire) - dequeue_position;
+    }
+
+    size_t GetCapacity() const {
+        return capacity_;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> enqueue_position_ = 0;
+    alignas(64) std::atomic<size_t> dequeue_position_ = 0;
+};
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include "durable_search_server.h"
+
+#include "file_sync.h"
+#include "mapped_search_server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#include <stdexcept>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::string_view SNAPSHOT_PREFIX = "snapshot-"sv;
+constexpr std::string_view SNAPSHOT_SUFFIX = ".index"sv;
+constexpr std::string_view LOG_PREFIX = "wal-"sv;
+constexpr std::string_view LOG_SUFFIX = ".log"sv;
+
+} // namespace
+
+DurableSearchServer::DurableSearchServer(const std::string& directory, std::string_view stop_words_text, WalOptions wal_options,
+    TermFreqStorage term_freq_storage)
+    : DurableSearchServer(directory, SplitIntoWords(stop_words_text), wal_options, term_freq_storage) {
+}
+
+DurableSearchServer::DurableSearchServer(const std::string& directory, const std::string& stop_words_text, WalOptions wal_options,
+    TermFreqStorage term_freq_storage)
+    : DurableSearchServer(directory, SplitIntoWords(stop_words_text), wal_options, term_freq_storage) {
+}
+
+DurableSearchServer::DurableSearchServer(const std::string& directory, std::unique_ptr<SearchServer> empty_index, WalOptions wal_options)
+    : directory_(directory)
+    , wal_options_(wal_options) {
+    std::filesystem::create_directories(directory_);
+    std::vector<uint64_t> snapshot_generations;
+    std::vector<uint64_t> log_generations;
+    for (const auto& entry : std::filesystem::directory_iterator(directory_)) {
+        const std::string name = entry.path().filename().string();
+        uint64_t generation;
+        if (ParseNumberedName(name, SNAPSHOT_PREFIX, SNAPSHOT_SUFFIX, generation)) {
+            snapshot_generations.push_back(generation);
+        }
+        else if (ParseNumberedName(name, LOG_PREFIX, LOG_SUFFIX, generation)) {
+            log_generations.push_back(generation);
+        }
+        else if (name.substr(0, SNAPSHOT_PREFIX.size()) == SNAPSHOT_PREFIX) {
+            // Left over from a checkpoint that did not finish.
+            std::filesystem::remove(entry.path());
+        }
+    }
+
+    std::sort(snapshot_generations.begin(), snapshot_generations.end());
+    if (!snapshot_generations.empty()) {
+        generation_ = snapshot_generation_ = snapshot_generations.back();
+        search_server_ = std::make_unique<SearchServer>(SearchServer::OpenMapped(GetSnapshotPath(generation_)));
+        for (size_t i = 0; i + 1 < snapshot_generations.size(); ++i) {
+            std::filesystem::remove(GetSnapshotPath(snapshot_generations[i]));
+        }
+    }
+    else {
+        search_server_ = std::move(empty_index);
+    }
+    std::sort(log_generations.begin(), log_generations.end());
+    for (const uint64_t generation : log_generations) {
+        if (generation < generation_) {
+            std::filesystem::remove(GetLogPath(generation));
+            continue;
+        }
+        const WalReplayResult result = WriteAheadLog::Replay(GetLogPath(generation), [this](const WalRecord& record) {
+            Apply(record);
+            });
+        if (result.truncated && generation != log_generations.back()) {
+            throw std::runtime_error("Write-ahead log "s + GetLogPath(generation) + " is corrupt"s);
+        }
+        recovered_record_count_ += result.record_count;
+        generation_ = generation;
+    }
+    log_ = std::make_shared<WriteAheadLog>(GetLogPath(generation_), wal_options_);
+}
+
+void DurableSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    const TokenizedDocument tokenized_document = search_server_->TokenizeDocument(document_id, document, status, ratings);
+    std::shared_ptr<WriteAheadLog> log;
+    uint64_t sequence;
+    {
+        std::unique_lock lock(mutex_);
+        search_server_->AddTokenizedDocument(tokenized_document);
+        log = log_;
+        const WalRecord record{ WalRecord::Type::ADD_DOCUMENT, document_id, status, ratings, std::string(document) };
+        sequence = log->Append(record);
+        Ship(record);
+    }
+    log->Commit(sequence);
+}
+
+void DurableSearchServer::RemoveDocument(int document_id) {
+    std::shared_ptr<WriteAheadLog> log;
+    uint64_t sequence;
+    {
+        std::unique_lock lock(mutex_);
+        if (!search_server_->ContainsDocument(document_id)) {
+            return;
+        }
+        search_server_->RemoveDocument(document_id);
+        log = log_;
+        const WalRecord record{ WalRecord::Type::REMOVE_DOCUMENT, document_id, DocumentStatus::ACTUAL, {}, {} };
+        sequence = log->Append(record);
+        Ship(record);
+    }
+    log->Commit(sequence);
+}
+
+std::vector<Document> DurableSearchServer::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(std::execution::seq, raw_query);
+}
+
+int DurableSearchServer::GetDocumentCount() const {
+    std::shared_lock lock(mutex_);
+    return search_server_->GetDocumentCount();
+}
+
+DurableSearchServer::~DurableSearchServer() {
+    WaitForCheckpoint();
+    if (checkpoint_thread_.joinable()) {
+        checkpoint_thread_.join();
+    }
+}
+
+// The log switches to the new generation at the fork, so the child's image holds exactly the
+// changes logged before it. The snapshot is synced under a temporary name and renamed, and the
+// older generations are deleted only after that, so a crash at any point leaves a snapshot
+// and every log after it.
+bool DurableSearchServer::StartCheckpoint() {
+    std::unique_lock checkpoint_lock(checkpoint_mutex_);
+    if (checkpoint_running_) {
+        return false;
+    }
+    if (checkpoint_thread_.joinable()) {
+        checkpoint_thread_.join();
+    }
+
+    // Only a checkpoint moves generation_, so under checkpoint_mutex_ it can be read without
+    // mutex_, and the next log is created before writers are held up.
+    const uint64_t generation = generation_ + 1;
+    auto log = std::make_shared<WriteAheadLog>(GetLogPath(generation), wal_options_);
+    const std::string partial_path = GetSnapshotPath(generation) + ".partial"s;
+    pid_t child_pid;
+    {
+        std::unique_lock lock(mutex_);
+        child_pid = fork();
+        if (child_pid == 0) {
+            // Only this thread exists in the child, and Save takes none of the index's locks.
+            int exit_code = 0;
+            try {
+                search_server_->Save(partial_path);
+            }
+            catch (...) {
+                exit_code = 1;
+            }
+            _exit(exit_code);
+        }
+        if (child_pid > 0) {
+            log_.swap(log);
+            generation_ = generation;
+        }
+    }
+    if (child_pid < 0) {
+        log.reset();
+        std::filesystem::remove(GetLogPath(generation));
+        throw std::runtime_error("Cannot fork a checkpoint process"s);
+    }
+    // The old log's records are written by their committers, or by its destructor once the
+    // last of them lets go of it; either way not under mutex_.
+    log.reset();
+
+    checkpoint_running_ = true;
+    checkpoint_thread_ = std::thread([this, child_pid, generation] {
+        FinishCheckpoint(child_pid, generation);
+        });
+    return true;
+}
+
+bool DurableSearchServer::WaitForCheckpoint() {
+    std::unique_lock checkpoint_lock(checkpoint_mutex_);
+    checkpoint_done_.wait(checkpoint_lock, [this] {
+        return !checkpoint_running_;
+        });
+    return checkpoint_succeeded_;
+}
+
+void DurableSearchServer::Checkpoint() {
+    WaitForCheckpoint();
+    StartCheckpoint();
+    if (!WaitForCheckpoint()) {
+        throw std::runtime_error("Cannot write snapshot to "s + directory_.string());
+    }
+}
+
+void DurableSearchServer::FinishCheckpoint(int child_pid, uint64_t generation) {
+    int status = 0;
+    while (waitpid(child_pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    const std::string snapshot_path = GetSnapshotPath(generation);
+    std::error_code error;
+    bool succeeded = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if (succeeded) {
+        std::filesystem::rename(snapshot_path + ".partial"s, snapshot_path, error);
+        try {
+            SyncPath(directory_);
+        }
+        catch (const std::runtime_error&) {
+            error = std::make_error_code(std::errc::io_error);
+        }
+        succeeded = !error;
+    }
+    else {
+        std::filesystem::remove(snapshot_path + ".partial"s, error);
+    }
+
+    std::lock_guard checkpoint_lock(checkpoint_mutex_);
+    if (succeeded) {
+        for (uint64_t old_generation = snapshot_generation_; old_generation < generation; ++old_generation) {
+            std::filesystem::remove(GetSnapshotPath(old_generation), error);
+            std::filesystem::remove(GetLogPath(old_generation), error);
+        }
+        snapshot_generation_ = generation;
+    }
+    checkpoint_succeeded_ = succeeded;
+    checkpoint_running_ = false;
+    checkpoint_done_.notify_all();
+}
+
+void DurableSearchServer::AddLogShipper(std::shared_ptr<LogShipper> shipper) {
+    std::unique_lock lock(mutex_);
+    shippers_.push_back(std::move(shipper));
+}
+
+uint64_t DurableSearchServer::GetGeneration() const {
+    std::shared_lock lock(mutex_);
+    return generation_;
+}
+
+size_t DurableSearchServer::GetRecoveredRecordCount() const {
+    return recovered_record_count_;
+}
+
+WalStats DurableSearchServer::GetWalStats() const {
+    std::shared_lock lock(mutex_);
+    return log_->GetStats();
+}
+
+std::string DurableSearchServer::GetSnapshotPath(uint64_t generation) const {
+    return (directory_ / (std::string(SNAPSHOT_PREFIX) + std::to_string(generation) + std::string(SNAPSHOT_SUFFIX))).string();
+}
+
+std::string DurableSearchServer::GetLogPath(uint64_t generation) const {
+    return (directory_ / (std::string(LOG_PREFIX) + std::to_string(generation) + std::string(LOG_SUFFIX))).string();
+}
+
+void DurableSearchServer::Apply(const WalRecord& record) {
+    if (record.type == WalRecord::Type::ADD_DOCUMENT) {
+        search_server_->AddDocument(record.document_id, record.text, record.status, record.ratings);
+    }
+    else {
+        search_server_->RemoveDocument(record.document_id);
+    }
+}
+
+void DurableSearchServer::Ship(const WalRecord& record) {
+    for (const auto& shipper : shippers_) {
+        shipper->Ship(record);
+    }
+}
\ No newline at end of file
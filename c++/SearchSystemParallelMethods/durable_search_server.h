@@ -0,0 +1,125 @@
+#pragma once
+
+#include "log_shipping.h"
+#include "search_server.h"
+#include "write_ahead_log.h"
+
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// SearchServer whose changes survive a crash. Its directory holds a snapshot of the index
+// (snapshot-<generation>.index, written by SearchServer::Save) and the write-ahead log of the
+// changes made since (wal-<generation>.log). AddDocument and RemoveDocument apply the change,
+// append it to the log and return once it is committed as the WalSyncPolicy says; queries may
+// see a change before its commit returns. A checkpoint starts the next generation's log and
+// writes its snapshot in the background; once the snapshot is on disk, the files of the older
+// generations are deleted. Opening a directory loads the newest snapshot and replays the logs
+// written after it, which covers a checkpoint that never finished.
+// Queries may run concurrently with each other and with writes. Writes are applied one at a
+// time, but writers that commit at the same time share one log write and sync.
+class DurableSearchServer {
+public:
+    // stop_words and term_freq_storage are used while the directory has no snapshot; once it
+    // has, the snapshot's own are.
+    template <typename StringContainer>
+    DurableSearchServer(const std::string& directory, const StringContainer& stop_words, WalOptions wal_options = {},
+        TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE);
+    DurableSearchServer(const std::string& directory, std::string_view stop_words_text, WalOptions wal_options = {},
+        TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE);
+    DurableSearchServer(const std::string& directory, const std::string& stop_words_text, WalOptions wal_options = {},
+        TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE);
+    // Waits for a running checkpoint.
+    ~DurableSearchServer();
+    DurableSearchServer(const DurableSearchServer&) = delete;
+    DurableSearchServer& operator=(const DurableSearchServer&) = delete;
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    void RemoveDocument(int document_id);
+
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, const PageRequest& page) const;
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const;
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    int GetDocumentCount() const;
+
+    // Forks a child process that writes the snapshot from its copy-on-write image of the index,
+    // so queries and writes only wait for the fork itself. Returns false, doing nothing, while
+    // another checkpoint is running.
+    bool StartCheckpoint();
+    // Returns whether the last checkpoint wrote its snapshot.
+    bool WaitForCheckpoint();
+    // StartCheckpoint and WaitForCheckpoint; throws if the snapshot could not be written.
+    void Checkpoint();
+
+    // Ships every change made from now on to a follower, in the order the changes are applied.
+    // Shipping is asynchronous: a follower may receive a change before its commit returns, and
+    // even one a crash loses when the sync policy is not EVERY_OPERATION.
+    void AddLogShipper(std::shared_ptr<LogShipper> shipper);
+
+    uint64_t GetGeneration() const;
+    // Log records replayed when the directory was opened.
+    size_t GetRecoveredRecordCount() const;
+    WalStats GetWalStats() const;
+
+private:
+    DurableSearchServer(const std::string& directory, std::unique_ptr<SearchServer> empty_index, WalOptions wal_options);
+
+    std::string GetSnapshotPath(uint64_t generation) const;
+    std::string GetLogPath(uint64_t generation) const;
+    void Apply(const WalRecord& record);
+    // Called with mutex_ held, so every shipper sees the changes in the order they were applied.
+    void Ship(const WalRecord& record);
+    void FinishCheckpoint(int child_pid, uint64_t generation);
+
+    const std::filesystem::path directory_;
+    const WalOptions wal_options_;
+
+    mutable std::shared_mutex mutex_;
+    std::unique_ptr<SearchServer> search_server_;
+    std::shared_ptr<WriteAheadLog> log_;
+    std::vector<std::shared_ptr<LogShipper>> shippers_;
+    // The generation of the current log.
+    uint64_t generation_ = 0;
+    size_t recovered_record_count_ = 0;
+
+    std::mutex checkpoint_mutex_;
+    std::condition_variable checkpoint_done_;
+    // The newest snapshot on disk; logs from its generation on are needed for recovery.
+    uint64_t snapshot_generation_ = 0;
+    bool checkpoint_running_ = false;
+    bool checkpoint_succeeded_ = true;
+    std::thread checkpoint_thread_;
+};
+
+template <typename StringContainer>
+DurableSearchServer::DurableSearchServer(const std::string& directory, const StringContainer& stop_words, WalOptions wal_options,
+    TermFreqStorage term_freq_storage)
+    : DurableSearchServer(directory, std::make_unique<SearchServer>(stop_words, term_freq_storage), wal_options) {
+}
+
+template <typename Scorer, typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> DurableSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate,
+    const PageRequest& page) const {
+    std::shared_lock lock(mutex_);
+    return search_server_->FindTopDocuments<Scorer>(policy, raw_query, document_predicate, page);
+}
+
+template <typename Scorer, typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> DurableSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return FindTopDocuments<Scorer>(policy, raw_query, document_predicate, PageRequest{});
+}
+
+template <typename Scorer, typename ExecutionPolicy>
+std::vector<Document> DurableSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const {
+    return FindTopDocuments<Scorer>(policy, raw_query, DocumentStatusPredicate{ DocumentStatus::ACTUAL });
+}
\ No newline at end of file
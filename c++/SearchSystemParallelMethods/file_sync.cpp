@@ -0,0 +1,23 @@
+#include "file_sync.h"
+
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+void SyncPath(const std::filesystem::path& path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || fsync(fd) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        throw std::runtime_error("Cannot sync " + path.string());
+    }
+    close(fd);
+}
+
+void SyncParentDirectory(const std::filesystem::path& path) {
+    const std::filesystem::path directory = path.parent_path();
+    SyncPath(directory.empty() ? std::filesystem::path(".") : directory);
+}
\ No newline at end of file
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <filesystem>
+
+// fsync of a file, or of a directory to persist the names created or renamed in it.
+void SyncPath(const std::filesystem::path& path);
+// Syncs the directory holding path, the working directory for a bare file name.
+void SyncParentDirectory(const std::filesystem::path& path);
\ No newline at end of file
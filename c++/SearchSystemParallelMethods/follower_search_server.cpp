@@ -0,0 +1,136 @@
+#include "follower_search_server.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t RECEIVE_BUFFER_SIZE = 64 * 1024;
+
+} // namespace
+
+FollowerSearchServer::FollowerSearchServer(std::string_view stop_words_text, std::unique_ptr<ReplicationTransport> transport,
+    TermFreqStorage term_freq_storage)
+    : FollowerSearchServer(SplitIntoWords(stop_words_text), std::move(transport), term_freq_storage) {
+}
+
+FollowerSearchServer::FollowerSearchServer(const std::string& stop_words_text, std::unique_ptr<ReplicationTransport> transport,
+    TermFreqStorage term_freq_storage)
+    : FollowerSearchServer(SplitIntoWords(stop_words_text), std::move(transport), term_freq_storage) {
+}
+
+FollowerSearchServer::FollowerSearchServer(std::unique_ptr<SearchServer> empty_index, std::unique_ptr<ReplicationTransport> transport)
+    : transport_(std::move(transport))
+    , search_server_(std::move(empty_index))
+    , receiver_([this] {
+        RunReceiver();
+        }) {
+}
+
+FollowerSearchServer::~FollowerSearchServer() {
+    transport_->Interrupt();
+    receiver_.join();
+}
+
+std::vector<Document> FollowerSearchServer::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(std::execution::seq, raw_query);
+}
+
+int FollowerSearchServer::GetDocumentCount() const {
+    std::shared_lock lock(mutex_);
+    return search_server_->GetDocumentCount();
+}
+
+ReplicationLag FollowerSearchServer::GetReplicationLag() const {
+    std::lock_guard lock(progress_mutex_);
+    ReplicationLag lag;
+    lag.applied_sequence = applied_sequence_;
+    if (applied_timestamp_us_ >= 0) {
+        const auto now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch());
+        // Clocks of two machines may disagree by a little; the follower is never ahead of now.
+        lag.staleness = std::max(now - std::chrono::microseconds(applied_timestamp_us_), std::chrono::microseconds::zero());
+    }
+    return lag;
+}
+
+bool FollowerSearchServer::IsFresherThan(std::chrono::microseconds max_staleness) const {
+    return GetReplicationLag().staleness <= max_staleness;
+}
+
+bool FollowerSearchServer::WaitForSequence(uint64_t sequence, std::chrono::milliseconds timeout) const {
+    std::unique_lock lock(progress_mutex_);
+    progress_.wait_for(lock, timeout, [this, sequence] {
+        return applied_sequence_ >= sequence || !streaming_;
+        });
+    return applied_sequence_ >= sequence;
+}
+
+bool FollowerSearchServer::IsStreaming() const {
+    std::lock_guard lock(progress_mutex_);
+    return streaming_;
+}
+
+// Frames may be split anywhere by the transport; a partial frame waits in the buffer for the
+// rest of it. A heartbeat is applied like a record without a change, advancing the time the
+// follower is known to be current at.
+void FollowerSearchServer::RunReceiver() {
+    std::string data;
+    std::vector<ReplicationFrame> frames;
+    try {
+        while (true) {
+            const size_t old_size = data.size();
+            data.resize(old_size + RECEIVE_BUFFER_SIZE);
+            const size_t received = transport_->Receive(data.data() + old_size, RECEIVE_BUFFER_SIZE);
+            data.resize(old_size + received);
+            if (received == 0) {
+                break;
+            }
+            size_t position = 0;
+            frames.clear();
+            for (ReplicationFrame frame; ReadReplicationFrame(data, position, frame);) {
+                frames.push_back(std::move(frame));
+            }
+            data.erase(0, position);
+            ApplyFrames(frames);
+        }
+    }
+    // A record the index rejects, such as an add of an id it already holds, ends the stream
+    // just as a broken connection does.
+    catch (const std::exception&) {
+    }
+    std::lock_guard lock(progress_mutex_);
+    streaming_ = false;
+    progress_.notify_all();
+}
+
+void FollowerSearchServer::ApplyFrames(const std::vector<ReplicationFrame>& frames) {
+    if (frames.empty()) {
+        return;
+    }
+    std::vector<TokenizedDocument> tokenized_documents;
+    for (const ReplicationFrame& frame : frames) {
+        if (frame.kind == ReplicationFrameKind::RECORD && frame.record.type == WalRecord::Type::ADD_DOCUMENT) {
+            const WalRecord& record = frame.record;
+            tokenized_documents.push_back(search_server_->TokenizeDocument(record.document_id, record.text, record.status, record.ratings));
+        }
+    }
+    {
+        std::unique_lock lock(mutex_);
+        auto tokenized_document = tokenized_documents.begin();
+        for (const ReplicationFrame& frame : frames) {
+            if (frame.kind != ReplicationFrameKind::RECORD) {
+                continue;
+            }
+            if (frame.record.type == WalRecord::Type::ADD_DOCUMENT) {
+                search_server_->AddTokenizedDocument(*tokenized_document++);
+            }
+            else if (search_server_->ContainsDocument(frame.record.document_id)) {
+                search_server_->RemoveDocument(frame.record.document_id);
+            }
+        }
+    }
+    std::lock_guard lock(progress_mutex_);
+    applied_sequence_ = frames.back().sequence;
+    applied_timestamp_us_ = frames.back().timestamp_us;
+    progress_.notify_all();
+}
\ No newline at end of file
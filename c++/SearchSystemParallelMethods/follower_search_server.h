@@ -0,0 +1,96 @@
+#pragma once
+
+#include "log_shipping.h"
+#include "search_server.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+
+// Read-only SearchServer kept up to date by a primary's LogShipper: a receiver thread reads
+// the changes from the transport and applies them in order, each batch that arrived together
+// under one lock. The follower must start from the state the primary had when its shipper
+// was attached, which for a new primary is an empty index with the same stop words.
+// GetReplicationLag tells how stale the follower is, so a router can send it only the
+// queries that tolerate that much staleness. Queries may run concurrently with each other and
+// with the receiver.
+class FollowerSearchServer {
+public:
+    template <typename StringContainer>
+    FollowerSearchServer(const StringContainer& stop_words, std::unique_ptr<ReplicationTransport> transport,
+        TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE);
+    FollowerSearchServer(std::string_view stop_words_text, std::unique_ptr<ReplicationTransport> transport,
+        TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE);
+    FollowerSearchServer(const std::string& stop_words_text, std::unique_ptr<ReplicationTransport> transport,
+        TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE);
+    // Stops receiving; the changes still in the transport are not applied.
+    ~FollowerSearchServer();
+    FollowerSearchServer(const FollowerSearchServer&) = delete;
+    FollowerSearchServer& operator=(const FollowerSearchServer&) = delete;
+
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, const PageRequest& page) const;
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const;
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    int GetDocumentCount() const;
+
+    ReplicationLag GetReplicationLag() const;
+    // Whether the follower has applied every change the primary made up to max_staleness ago.
+    bool IsFresherThan(std::chrono::microseconds max_staleness) const;
+    // Waits until the change numbered sequence is applied, for reading one's own writes;
+    // returns false on timeout or if the stream ends first.
+    bool WaitForSequence(uint64_t sequence, std::chrono::milliseconds timeout) const;
+    // False once the primary ended the stream or it broke; the follower then stays as it is.
+    bool IsStreaming() const;
+
+private:
+    FollowerSearchServer(std::unique_ptr<SearchServer> empty_index, std::unique_ptr<ReplicationTransport> transport);
+
+    void RunReceiver();
+    void ApplyFrames(const std::vector<ReplicationFrame>& frames);
+
+    const std::unique_ptr<ReplicationTransport> transport_;
+
+    mutable std::shared_mutex mutex_;
+    std::unique_ptr<SearchServer> search_server_;
+
+    mutable std::mutex progress_mutex_;
+    mutable std::condition_variable progress_;
+    uint64_t applied_sequence_ = 0;
+    // The primary's wall clock time of the last frame applied, or -1 before the first.
+    int64_t applied_timestamp_us_ = -1;
+    bool streaming_ = true;
+
+    std::thread receiver_;
+};
+
+template <typename StringContainer>
+FollowerSearchServer::FollowerSearchServer(const StringContainer& stop_words, std::unique_ptr<ReplicationTransport> transport,
+    TermFreqStorage term_freq_storage)
+    : FollowerSearchServer(std::make_unique<SearchServer>(stop_words, term_freq_storage), std::move(transport)) {
+}
+
+template <typename Scorer, typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> FollowerSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate,
+    const PageRequest& page) const {
+    std::shared_lock lock(mutex_);
+    return search_server_->FindTopDocuments<Scorer>(policy, raw_query, document_predicate, page);
+}
+
+template <typename Scorer, typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> FollowerSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return FindTopDocuments<Scorer>(policy, raw_query, document_predicate, PageRequest{});
+}
+
+template <typename Scorer, typename ExecutionPolicy>
+std::vector<Document> FollowerSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const {
+    return FindTopDocuments<Scorer>(policy, raw_query, DocumentStatusPredicate{ DocumentStatus::ACTUAL });
+}
\ No newline at end of file
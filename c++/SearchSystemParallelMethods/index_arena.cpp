@@ -0,0 +1,188 @@
+#include "index_arena.h"
+
+#include <algorithm>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+size_t AlignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+IndexArena::IndexArena(IndexHugePages huge_pages) : huge_pages_(huge_pages) {
+}
+
+IndexArena::~IndexArena() {
+    for (const auto& [base, slab] : slabs_) {
+        Unmap(base, SLAB_SIZE);
+    }
+    for (const auto& [pointer, mapping] : large_blocks_) {
+        Unmap(pointer, mapping.size);
+    }
+}
+
+IndexHugePages IndexArena::GetHugePages() const {
+    return huge_pages_;
+}
+
+IndexArenaStats IndexArena::GetStats() const {
+    IndexArenaStats stats;
+    stats.slab_count = slabs_.size();
+    stats.large_block_count = large_blocks_.size();
+    stats.used_bytes = used_bytes_;
+    for (const auto& [base, slab] : slabs_) {
+        stats.reserved_bytes += SLAB_SIZE;
+        stats.huge_page_bytes += slab.huge ? SLAB_SIZE : 0;
+    }
+    for (const auto& [pointer, mapping] : large_blocks_) {
+        stats.reserved_bytes += mapping.size;
+        stats.huge_page_bytes += mapping.huge ? mapping.size : 0;
+    }
+    return stats;
+}
+
+void* IndexArena::do_allocate(size_t bytes, size_t alignment) {
+    if (bytes > SLAB_SIZE || alignment > SLAB_SIZE) {
+        Mapping mapping{ AlignUp(bytes, huge_pages_ == IndexHugePages::NONE ? 4096 : SLAB_SIZE), false };
+        void* pointer = Map(mapping.size, alignment, mapping.huge);
+        large_blocks_.emplace(pointer, mapping);
+        used_bytes_ += mapping.size;
+        return pointer;
+    }
+    // Blocks are aligned to their own size, which covers any alignment up to it.
+    const int order = GetOrder(std::max(bytes, alignment));
+    int free_order = order;
+    while (free_order <= SLAB_ORDER && free_lists_[free_order] == nullptr) {
+        ++free_order;
+    }
+    if (free_order > SLAB_ORDER) {
+        AddSlab();
+        free_order = SLAB_ORDER;
+    }
+    std::byte* block = reinterpret_cast<std::byte*>(free_lists_[free_order]);
+    RemoveFree(block, free_order);
+    while (free_order > order) {
+        --free_order;
+        PushFree(block + (size_t(1) << free_order), free_order);
+    }
+    used_bytes_ += size_t(1) << order;
+    return block;
+}
+
+void IndexArena::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    if (bytes > SLAB_SIZE || alignment > SLAB_SIZE) {
+        const auto block_it = large_blocks_.find(pointer);
+        used_bytes_ -= block_it->second.size;
+        Unmap(pointer, block_it->second.size);
+        large_blocks_.erase(block_it);
+        return;
+    }
+    int order = GetOrder(std::max(bytes, alignment));
+    used_bytes_ -= size_t(1) << order;
+    std::byte* block = static_cast<std::byte*>(pointer);
+    while (order < SLAB_ORDER) {
+        const auto offset = reinterpret_cast<uintptr_t>(block) & (SLAB_SIZE - 1);
+        std::byte* buddy = block - offset + (offset ^ (size_t(1) << order));
+        if (FreeOrderAt(buddy) != order) {
+            break;
+        }
+        RemoveFree(buddy, order);
+        block = std::min(block, buddy);
+        ++order;
+    }
+    PushFree(block, order);
+}
+
+bool IndexArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+int IndexArena::GetOrder(size_t bytes) {
+    int order = MIN_ORDER;
+    while ((size_t(1) << order) < bytes) {
+        ++order;
+    }
+    return order;
+}
+
+void IndexArena::AddSlab() {
+    Slab slab{ false, std::vector<uint8_t>(SLAB_SIZE / MIN_BLOCK_SIZE, 0) };
+    std::byte* base = static_cast<std::byte*>(Map(SLAB_SIZE, SLAB_SIZE, slab.huge));
+    slabs_.emplace(base, std::move(slab));
+    PushFree(base, SLAB_ORDER);
+}
+
+void IndexArena::PushFree(std::byte* block, int order) {
+    FreeBlock* free_block = reinterpret_cast<FreeBlock*>(block);
+    free_block->prev = nullptr;
+    free_block->next = free_lists_[order];
+    if (free_block->next != nullptr) {
+        free_block->next->prev = free_block;
+    }
+    free_lists_[order] = free_block;
+    FreeOrderAt(block) = static_cast<uint8_t>(order);
+}
+
+void IndexArena::RemoveFree(std::byte* block, int order) {
+    FreeBlock* free_block = reinterpret_cast<FreeBlock*>(block);
+    if (free_block->prev != nullptr) {
+        free_block->prev->next = free_block->next;
+    }
+    else {
+        free_lists_[order] = free_block->next;
+    }
+    if (free_block->next != nullptr) {
+        free_block->next->prev = free_block->prev;
+    }
+    FreeOrderAt(block) = 0;
+}
+
+uint8_t& IndexArena::FreeOrderAt(std::byte* block) {
+    const auto offset = reinterpret_cast<uintptr_t>(block) & (SLAB_SIZE - 1);
+    return slabs_.find(block - offset)->second.free_orders[offset / MIN_BLOCK_SIZE];
+}
+
+void* IndexArena::Map(size_t size, size_t alignment, bool& huge) const {
+#ifdef __linux__
+    if (huge_pages_ == IndexHugePages::EXPLICIT && size % SLAB_SIZE == 0 && alignment <= SLAB_SIZE) {
+        void* pointer = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (pointer != MAP_FAILED) {
+            huge = true;
+            return pointer;
+        }
+    }
+    // Over-map and trim to get the alignment; slabs must start on a 2 MiB boundary.
+    const size_t padding = alignment > 4096 ? alignment : 0;
+    void* mapped = mmap(nullptr, size + padding, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    std::byte* begin = static_cast<std::byte*>(mapped);
+    std::byte* pointer = begin + (AlignUp(reinterpret_cast<uintptr_t>(begin), padding == 0 ? 1 : padding) - reinterpret_cast<uintptr_t>(begin));
+    if (pointer > begin) {
+        munmap(begin, pointer - begin);
+    }
+    if (begin + size + padding > pointer + size) {
+        munmap(pointer + size, begin + size + padding - (pointer + size));
+    }
+    huge = huge_pages_ != IndexHugePages::NONE && madvise(pointer, size, MADV_HUGEPAGE) == 0;
+    return pointer;
+#else
+    huge = false;
+    return ::operator new(size, std::align_val_t(std::max(alignment, SLAB_SIZE)));
+#endif
+}
+
+void IndexArena::Unmap(void* pointer, size_t size) {
+#ifdef __linux__
+    munmap(pointer, size);
+#else
+    ::operator delete(pointer, std::align_val_t(SLAB_SIZE));
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <vector>
+
+// How IndexArena backs its slabs.
+//   NONE        - plain anonymous mappings.
+//   TRANSPARENT - mappings advised with MADV_HUGEPAGE, so the kernel may back them with 2 MiB pages.
+//   EXPLICIT    - MAP_HUGETLB mappings from the reserved huge page pool; falls back to
+//                 TRANSPARENT for any slab the pool cannot serve.
+enum class IndexHugePages {
+    NONE,
+    TRANSPARENT,
+    EXPLICIT,
+};
+
+// used_bytes counts the blocks handed out (rounded to their buddy size), so used / reserved
+// is how full the slabs are. huge_page_bytes are mapped from the huge page pool or advised
+// for transparent huge pages.
+struct IndexArenaStats {
+    size_t reserved_bytes = 0;
+    size_t used_bytes = 0;
+    size_t huge_page_bytes = 0;
+    size_t slab_count = 0;
+    size_t large_block_count = 0;
+
+    double GetUtilization() const {
+        return reserved_bytes == 0 ? 0.0 : used_bytes * 1.0 / reserved_bytes;
+    }
+};
+
+// Upstream of the index containers: a buddy allocator over 2 MiB aligned slabs. Blocks are
+// powers of two from MIN_BLOCK_SIZE up to a whole slab, and a freed block merges with its
+// free buddy, so the space a posting vector leaves behind when it doubles can be reused by
+// the next one. Blocks larger than a slab get a mapping of their own. Not synchronized: the
+// index is mutated by one writer at a time.
+class IndexArena : public std::pmr::memory_resource {
+public:
+    explicit IndexArena(IndexHugePages huge_pages = IndexHugePages::NONE);
+    ~IndexArena() override;
+    IndexArena(const IndexArena&) = delete;
+    IndexArena& operator=(const IndexArena&) = delete;
+
+    IndexHugePages GetHugePages() const;
+    IndexArenaStats GetStats() const;
+
+    static constexpr size_t SLAB_SIZE = size_t(2) << 20;
+    static constexpr size_t MIN_BLOCK_SIZE = 512;
+
+private:
+    static constexpr int MIN_ORDER = 9;
+    static constexpr int SLAB_ORDER = 21;
+    static_assert(size_t(1) << MIN_ORDER == MIN_BLOCK_SIZE && size_t(1) << SLAB_ORDER == SLAB_SIZE);
+
+    struct FreeBlock {
+        FreeBlock* prev;
+        FreeBlock* next;
+    };
+
+    // free_orders[i] is the order of the free block starting at the i-th MIN_BLOCK_SIZE unit, or 0.
+    struct Slab {
+        bool huge;
+        std::vector<uint8_t> free_orders;
+    };
+
+    struct Mapping {
+        size_t size;
+        bool huge;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    static int GetOrder(size_t bytes);
+    void AddSlab();
+    void PushFree(std::byte* block, int order);
+    void RemoveFree(std::byte* block, int order);
+    uint8_t& FreeOrderAt(std::byte* block);
+
+    void* Map(size_t size, size_t alignment, bool& huge) const;
+    static void Unmap(void* pointer, size_t size);
+
+    const IndexHugePages huge_pages_;
+    std::map<std::byte*, Slab> slabs_;
+    std::map<void*, Mapping> large_blocks_;
+    FreeBlock* free_lists_[SLAB_ORDER + 1] = {};
+    size_t used_bytes_ = 0;
+};
\ No newline at end of file
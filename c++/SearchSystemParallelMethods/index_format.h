@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Layout of the files SearchServer::Save writes and MappedSearchServer serves. A file is the
+// header followed by the sections in IndexSection order, each starting on an
+// INDEX_SECTION_ALIGNMENT boundary, so that every array can be used in place once the file
+// is mapped. Numbers are stored in the byte order of the machine that wrote the file;
+// byte_order tells a reader with the other order to reject it.
+constexpr char INDEX_FILE_MAGIC[8] = { 'S', 'R', 'C', 'H', 'I', 'D', 'X', '\0' };
+constexpr uint32_t INDEX_FILE_VERSION = 1;
+constexpr uint32_t INDEX_BYTE_ORDER_MARK = 0x01020304;
+constexpr size_t INDEX_SECTION_ALIGNMENT = 64;
+
+// Terms are numbered in ascending order. Slots are renumbered densely on save, skipping
+// removed documents.
+enum class IndexSection : uint32_t {
+    STOP_WORD_OFFSETS,        // uint64 [stop_word_count + 1] into STOP_WORD_CHARS
+    STOP_WORD_CHARS,
+    TERM_OFFSETS,             // uint64 [term_count + 1] into TERM_CHARS
+    TERM_CHARS,
+    POSTING_OFFSETS,          // uint64 [term_count + 1] into POSTING_SLOTS and POSTING_TERM_FREQS
+    POSTING_SLOTS,            // uint32 [posting_count], ascending within a term
+    POSTING_TERM_FREQS,       // double, float or uint16 [posting_count], as term_freq_storage says
+    DOCUMENT_IDS,             // int32 [slot_count]
+    DOCUMENT_RATINGS,         // int32 [slot_count]
+    DOCUMENT_STATUSES,        // int32 [slot_count]
+    DOCUMENT_WORD_COUNTS,     // int32 [slot_count]
+    DOCUMENT_INV_WORD_COUNTS, // double [slot_count]
+    FORWARD_OFFSETS,          // uint64 [slot_count + 1] into FORWARD_TERMS
+    FORWARD_TERMS,            // uint32 [forward_term_count] term numbers, ascending within a slot
+    SORTED_IDS,               // int32 [slot_count], ascending
+    SORTED_ID_SLOTS,          // uint32 [slot_count], the slot of SORTED_IDS[i]
+    COUNT,
+};
+
+struct IndexFileSection {
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct IndexFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t term_freq_storage;
+    uint32_t reserved;
+    uint64_t stop_word_count;
+    uint64_t term_count;
+    uint64_t posting_count;
+    uint64_t slot_count;
+    uint64_t forward_term_count;
+    int64_t total_word_count;
+    IndexFileSection sections[static_cast<size_t>(IndexSection::COUNT)];
+};
\ No newline at end of file
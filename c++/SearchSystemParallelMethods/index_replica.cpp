@@ -0,0 +1,186 @@
+#include "index_replica.h"
+
+#include "file_sync.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::string_view INDEX_PREFIX = "index-"sv;
+constexpr std::string_view INDEX_SUFFIX = ".index"sv;
+const std::string CURRENT_NAME = "CURRENT"s;
+
+std::filesystem::path GetIndexPath(const std::filesystem::path& directory, uint64_t generation) {
+    return directory / (std::string(INDEX_PREFIX) + std::to_string(generation) + std::string(INDEX_SUFFIX));
+}
+
+} // namespace
+
+IndexPublisher::IndexPublisher(const std::string& directory, size_t kept_generation_count)
+    : directory_(directory)
+    , kept_generation_count_(kept_generation_count) {
+    if (kept_generation_count_ == 0) {
+        throw std::invalid_argument("At least one generation must be kept"s);
+    }
+    std::filesystem::create_directories(directory_);
+    for (const auto& entry : std::filesystem::directory_iterator(directory_)) {
+        uint64_t generation;
+        if (ParseNumberedName(entry.path().filename().string(), INDEX_PREFIX, INDEX_SUFFIX, generation)) {
+            generation_ = std::max(generation_, generation);
+        }
+    }
+}
+
+uint64_t IndexPublisher::Publish(const SearchServer& search_server) {
+    const uint64_t generation = generation_ + 1;
+    search_server.Save(GetIndexPath(directory_, generation).string());
+    const std::filesystem::path temporary_path = directory_ / (CURRENT_NAME + ".tmp"s);
+    {
+        std::ofstream current(temporary_path, std::ios::trunc);
+        current << generation;
+        current.close();
+        if (!current) {
+            throw std::runtime_error("Cannot write "s + temporary_path.string());
+        }
+    }
+    SyncPath(temporary_path);
+    std::filesystem::rename(temporary_path, directory_ / CURRENT_NAME);
+    SyncPath(directory_);
+    generation_ = generation;
+
+    for (const auto& entry : std::filesystem::directory_iterator(directory_)) {
+        uint64_t old_generation;
+        if (ParseNumberedName(entry.path().filename().string(), INDEX_PREFIX, INDEX_SUFFIX, old_generation)
+            && old_generation + kept_generation_count_ <= generation) {
+            std::filesystem::remove(entry.path());
+        }
+    }
+    return generation;
+}
+
+uint64_t IndexPublisher::GetGeneration() const {
+    return generation_;
+}
+
+IndexReplica::IndexReplica(const std::string& directory, std::chrono::milliseconds refresh_interval)
+    : directory_(directory)
+    , current_(LoadNewerThan(0)) {
+    if (current_ == nullptr) {
+        throw std::runtime_error("No index published in "s + directory);
+    }
+    if (refresh_interval.count() > 0) {
+        refresher_ = std::thread([this, refresh_interval] {
+            std::unique_lock lock(stop_mutex_);
+            while (!stop_wanted_.wait_for(lock, refresh_interval, [this] { return stopping_; })) {
+                try {
+                    Refresh();
+                }
+                catch (const std::runtime_error&) {
+                    // A publisher in the middle of cleaning up; the next round retries.
+                }
+            }
+            });
+    }
+}
+
+IndexReplica::~IndexReplica() {
+    {
+        std::lock_guard lock(stop_mutex_);
+        stopping_ = true;
+    }
+    stop_wanted_.notify_all();
+    if (refresher_.joinable()) {
+        refresher_.join();
+    }
+}
+
+bool IndexReplica::Refresh() {
+    std::lock_guard lock(refresh_mutex_);
+    std::shared_ptr<const Generation> latest = LoadNewerThan(std::atomic_load(&current_)->number);
+    if (latest == nullptr) {
+        return false;
+    }
+    std::atomic_store(&current_, std::move(latest));
+    return true;
+}
+
+std::shared_ptr<const MappedSearchServer> IndexReplica::GetIndex() const {
+    std::shared_ptr<const Generation> generation = std::atomic_load(&current_);
+    return std::shared_ptr<const MappedSearchServer>(generation, &generation->index);
+}
+
+uint64_t IndexReplica::GetGeneration() const {
+    return std::atomic_load(&current_)->number;
+}
+
+std::vector<Document> IndexReplica::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(std::execution::seq, raw_query);
+}
+
+// The publisher may delete the generation CURRENT named before it is opened, once newer ones
+// were published; CURRENT has moved on by then, so it is read again.
+std::shared_ptr<const IndexReplica::Generation> IndexReplica::LoadNewerThan(uint64_t generation) const {
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        std::ifstream current(directory_ / CURRENT_NAME);
+        uint64_t number;
+        if (!(current >> number) || number <= generation) {
+            return nullptr;
+        }
+        const std::filesystem::path path = GetIndexPath(directory_, number);
+        try {
+            return std::make_shared<const Generation>(Generation{ number, MappedSearchServer(path.string()) });
+        }
+        catch (const std::runtime_error&) {
+            if (std::filesystem::exists(path)) {
+                throw;
+            }
+        }
+    }
+    throw std::runtime_error("Cannot open the current index in "s + directory_.string());
+}
+
+ReplicaProcessPool::ReplicaProcessPool(const std::string& directory, size_t worker_count, const Worker& worker,
+    std::chrono::milliseconds refresh_interval) {
+    for (size_t worker_index = 0; worker_index < worker_count; ++worker_index) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            int exit_code = 1;
+            try {
+                IndexReplica replica(directory, refresh_interval);
+                exit_code = worker(replica, worker_index);
+            }
+            catch (...) {
+            }
+            std::cout.flush();
+            _exit(exit_code);
+        }
+        if (pid < 0) {
+            Wait();
+            throw std::runtime_error("Cannot fork a replica process"s);
+        }
+        worker_pids_.push_back(pid);
+    }
+}
+
+ReplicaProcessPool::~ReplicaProcessPool() {
+    Wait();
+}
+
+std::vector<int> ReplicaProcessPool::Wait() {
+    std::vector<int> exit_codes;
+    for (const int pid : worker_pids_) {
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+        }
+        exit_codes.push_back(WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+    }
+    worker_pids_.clear();
+    return exit_codes;
+}
\ No newline at end of file
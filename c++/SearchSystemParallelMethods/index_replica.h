@@ -0,0 +1,111 @@
+#pragma once
+
+#include "mapped_search_server.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writer side of a published index directory. Each Publish saves the index as the sealed file
+// index-<generation>.index and then points the CURRENT file at it by renaming a new CURRENT
+// over the old one, so readers see either the previous generation or the new one, whole.
+// Generations older than the last kept_generation_count are deleted; a reader that still maps
+// one keeps its pages until it unmaps it.
+class IndexPublisher {
+public:
+    explicit IndexPublisher(const std::string& directory, size_t kept_generation_count = 2);
+
+    // Returns the generation published, counted on from the newest one in the directory.
+    uint64_t Publish(const SearchServer& search_server);
+    uint64_t GetGeneration() const;
+
+private:
+    const std::filesystem::path directory_;
+    const size_t kept_generation_count_;
+    uint64_t generation_ = 0;
+};
+
+// Reader side: serves queries from the current generation of a published directory, mapped
+// read-only, so every process reading the directory shares one copy of the index in the page
+// cache. Refresh maps a newer generation, if there is one, and swaps it in atomically: queries
+// already running finish on the old mapping, which is unmapped when the last of them is done.
+// With a refresh_interval, a background thread calls Refresh that often. Thread-safe.
+class IndexReplica {
+public:
+    explicit IndexReplica(const std::string& directory, std::chrono::milliseconds refresh_interval = std::chrono::milliseconds::zero());
+    ~IndexReplica();
+    IndexReplica(const IndexReplica&) = delete;
+    IndexReplica& operator=(const IndexReplica&) = delete;
+
+    // Returns whether a newer generation was swapped in.
+    bool Refresh();
+
+    // Pins the current generation for as long as the pointer lives.
+    std::shared_ptr<const MappedSearchServer> GetIndex() const;
+    uint64_t GetGeneration() const;
+
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, const PageRequest& page) const;
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+private:
+    struct Generation {
+        uint64_t number;
+        MappedSearchServer index;
+    };
+
+    // Maps the generation CURRENT names if it is newer than generation, or returns nullptr.
+    std::shared_ptr<const Generation> LoadNewerThan(uint64_t generation) const;
+
+    const std::filesystem::path directory_;
+    // Read and replaced with the std::atomic_load / atomic_store overloads for shared_ptr.
+    std::shared_ptr<const Generation> current_;
+    std::mutex refresh_mutex_;
+
+    std::mutex stop_mutex_;
+    std::condition_variable stop_wanted_;
+    bool stopping_ = false;
+    std::thread refresher_;
+};
+
+// Forks worker_count processes that each open an IndexReplica of directory and run
+// worker(replica, worker_index); its result is the process's exit code. A worker starts with
+// only the forking thread, so it must not use a ThreadPool or parallel policy state it
+// inherited; it can create its own.
+class ReplicaProcessPool {
+public:
+    using Worker = std::function<int(IndexReplica& replica, size_t worker_index)>;
+
+    ReplicaProcessPool(const std::string& directory, size_t worker_count, const Worker& worker,
+        std::chrono::milliseconds refresh_interval = std::chrono::milliseconds(100));
+    // Waits for the workers.
+    ~ReplicaProcessPool();
+    ReplicaProcessPool(const ReplicaProcessPool&) = delete;
+    ReplicaProcessPool& operator=(const ReplicaProcessPool&) = delete;
+
+    // Waits for every worker and returns their exit codes, or -1 for a worker that did not exit normally.
+    std::vector<int> Wait();
+
+private:
+    std::vector<int> worker_pids_;
+};
+
+template <typename Scorer, typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> IndexReplica::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate,
+    const PageRequest& page) const {
+    return GetIndex()->FindTopDocuments<Scorer>(policy, raw_query, document_predicate, page);
+}
+
+template <typename Scorer, typename ExecutionPolicy>
+std::vector<Document> IndexReplica::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const {
+    return GetIndex()->FindTopDocuments<Scorer>(policy, raw_query);
+}
\ No newline at end of file
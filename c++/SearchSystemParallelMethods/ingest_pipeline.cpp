@@ -0,0 +1,167 @@
+#include "ingest_pipeline.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Spins briefly, then yields, then sleeps, so that idle stages on a quiet feed do not each burn a core.
+class Backoff {
+public:
+    void Wait() {
+        if (attempt_ < SPIN_ATTEMPTS) {
+            ++attempt_;
+        }
+        else if (attempt_ < SPIN_ATTEMPTS + YIELD_ATTEMPTS) {
+            ++attempt_;
+            std::this_thread::yield();
+        }
+        else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+private:
+    static constexpr int SPIN_ATTEMPTS = 64;
+    static constexpr int YIELD_ATTEMPTS = 64;
+
+    int attempt_ = 0;
+};
+
+int64_t GetNanosecondsSince(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+} // namespace
+
+const size_t IngestPipeline::DEFAULT_TOKENIZER_COUNT = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+IngestPipeline::IngestPipeline(SearchServer& search_server, size_t tokenizer_count, size_t queue_capacity)
+    : search_server_(search_server)
+    , indexer_queue_(queue_capacity) {
+    for (size_t i = 0; i < std::max<size_t>(1, tokenizer_count); ++i) {
+        tokenizers_.push_back(std::make_unique<Tokenizer>(queue_capacity));
+    }
+    for (const auto& tokenizer : tokenizers_) {
+        tokenizer->thread = std::thread([this, &tokenizer = *tokenizer] {
+            RunTokenizer(tokenizer);
+            });
+    }
+    indexer_thread_ = std::thread([this] {
+        RunIndexer();
+        });
+}
+
+IngestPipeline::~IngestPipeline() {
+    Drain();
+    stopping_ = true;
+    for (const auto& tokenizer : tokenizers_) {
+        tokenizer->thread.join();
+    }
+    indexer_thread_.join();
+}
+
+void IngestPipeline::Submit(int document_id, std::string document, DocumentStatus status, std::vector<int> ratings) {
+    RawDocument raw_document{ document_id, std::move(document), status, std::move(ratings) };
+    const auto start = Clock::now();
+    reader_counters_.busy_nanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(start - reader_resume_time_).count(),
+        std::memory_order_relaxed);
+    // Prefer the next tokenizer in turn, but any with room will do before blocking.
+    for (Backoff backoff;; backoff.Wait()) {
+        for (size_t attempt = 0; attempt < tokenizers_.size(); ++attempt) {
+            Tokenizer& tokenizer = *tokenizers_[next_tokenizer_];
+            next_tokenizer_ = (next_tokenizer_ + 1) % tokenizers_.size();
+            if (tokenizer.queue.TryPush(std::move(raw_document))) {
+                UpdateMaxDepth(tokenizer.max_queue_depth, tokenizer.queue.GetDepth());
+                reader_counters_.blocked_nanoseconds.fetch_add(GetNanosecondsSince(start), std::memory_order_relaxed);
+                reader_counters_.document_count.fetch_add(1, std::memory_order_relaxed);
+                submitted_count_.fetch_add(1, std::memory_order_relaxed);
+                reader_resume_time_ = Clock::now();
+                return;
+            }
+        }
+    }
+}
+
+void IngestPipeline::Drain() {
+    for (Backoff backoff; finished_count_.load(std::memory_order_acquire) < submitted_count_.load(std::memory_order_relaxed); backoff.Wait()) {
+    }
+    reader_resume_time_ = Clock::now();
+}
+
+IngestPipelineMetrics IngestPipeline::GetMetrics() const {
+    IngestPipelineMetrics metrics;
+    metrics.elapsed_time = Clock::now() - start_time_;
+    reader_counters_.Add(metrics.reader);
+    indexer_counters_.Add(metrics.indexer);
+    for (const auto& tokenizer : tokenizers_) {
+        tokenizer->counters.Add(metrics.tokenizer);
+        metrics.tokenizer_queues.push_back({ tokenizer->queue.GetCapacity(), tokenizer->queue.GetDepth(), tokenizer->max_queue_depth.load() });
+    }
+    metrics.indexer_queue = { indexer_queue_.GetCapacity(), indexer_queue_.GetDepth(), max_indexer_queue_depth_.load() };
+    metrics.rejected_document_count = rejected_count_.load();
+    return metrics;
+}
+
+void IngestPipeline::RunTokenizer(Tokenizer& tokenizer) {
+    RawDocument raw_document;
+    for (Backoff backoff; !stopping_.load(std::memory_order_acquire); backoff.Wait()) {
+        if (!tokenizer.queue.TryPop(raw_document)) {
+            continue;
+        }
+        backoff = Backoff();
+        const auto start = Clock::now();
+        TokenizedItem item;
+        try {
+            item.document = search_server_.TokenizeDocument(raw_document.id, raw_document.text, raw_document.status, raw_document.ratings);
+            item.is_valid = true;
+        }
+        catch (const std::invalid_argument&) {
+        }
+        tokenizer.counters.busy_nanoseconds.fetch_add(GetNanosecondsSince(start), std::memory_order_relaxed);
+
+        const auto blocked_start = Clock::now();
+        for (Backoff push_backoff; !indexer_queue_.TryPush(std::move(item)); push_backoff.Wait()) {
+        }
+        UpdateMaxDepth(max_indexer_queue_depth_, indexer_queue_.GetDepth());
+        tokenizer.counters.blocked_nanoseconds.fetch_add(GetNanosecondsSince(blocked_start), std::memory_order_relaxed);
+        tokenizer.counters.document_count.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void IngestPipeline::RunIndexer() {
+    TokenizedItem item;
+    for (Backoff backoff; !stopping_.load(std::memory_order_acquire); backoff.Wait()) {
+        if (!indexer_queue_.TryPop(item)) {
+            continue;
+        }
+        backoff = Backoff();
+        const auto start = Clock::now();
+        bool is_indexed = false;
+        if (item.is_valid) {
+            try {
+                search_server_.AddTokenizedDocument(item.document);
+                is_indexed = true;
+            }
+            catch (const std::invalid_argument&) {
+            }
+        }
+        indexer_counters_.busy_nanoseconds.fetch_add(GetNanosecondsSince(start), std::memory_order_relaxed);
+        indexer_counters_.document_count.fetch_add(1, std::memory_order_relaxed);
+        if (!is_indexed) {
+            rejected_count_.fetch_add(1, std::memory_order_relaxed);
+        }
+        finished_count_.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void IngestPipeline::UpdateMaxDepth(std::atomic<size_t>& max_depth, size_t depth) {
+    size_t current = max_depth.load(std::memory_order_relaxed);
+    while (depth > current && !max_depth.compare_exchange_weak(current, depth, std::memory_order_relaxed)) {
+    }
+}
+
+void IngestPipeline::StageCounters::Add(IngestStageMetrics& metrics) const {
+    metrics.document_count += document_count.load(std::memory_order_relaxed);
+    metrics.busy_time += std::chrono::nanoseconds(busy_nanoseconds.load(std::memory_order_relaxed));
+    metrics.blocked_time += std::chrono::nanoseconds(blocked_nanoseconds.load(std::memory_order_relaxed));
+}
\ No newline at end of file
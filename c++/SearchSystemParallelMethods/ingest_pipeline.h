@@ -0,0 +1,123 @@
+#pragma once
+
+#include "bounded_queue.h"
+#include "search_server.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// busy_time is spent on the stage's own work, blocked_time waiting for room in the next
+// queue. A stage that is busy most of the elapsed time while the stages before it are
+// blocked is the bottleneck.
+struct IngestStageMetrics {
+    size_t document_count = 0;
+    std::chrono::nanoseconds busy_time{};
+    std::chrono::nanoseconds blocked_time{};
+
+    // Documents per second of busy time: what the stage could sustain on its own.
+    double GetThroughput() const {
+        return busy_time.count() == 0 ? 0.0 : document_count * 1e9 / busy_time.count();
+    }
+};
+
+struct IngestQueueMetrics {
+    size_t capacity = 0;
+    size_t depth = 0;
+    size_t max_depth = 0;
+};
+
+// Tokenizer stage metrics are summed over its threads. The reader's work happens in the
+// caller, so its busy_time is the time between Submit calls (reading and building the next
+// document; on a quiet feed, also waiting for it), apart from time spent in Drain.
+struct IngestPipelineMetrics {
+    std::chrono::nanoseconds elapsed_time{};
+    IngestStageMetrics reader;
+    IngestStageMetrics tokenizer;
+    IngestStageMetrics indexer;
+    std::vector<IngestQueueMetrics> tokenizer_queues;
+    IngestQueueMetrics indexer_queue;
+    size_t rejected_document_count = 0;
+};
+
+// Continuous ingest into a SearchServer in three stages:
+//   reader    - the thread calling Submit; it deals documents round-robin to the tokenizers'
+//               SPSC queues and blocks while all of them are full.
+//   tokenizer - tokenizer_count threads running SearchServer::TokenizeDocument; results go
+//               to one MPSC queue and a tokenizer blocks while it is full.
+//   indexer   - one thread running SearchServer::AddTokenizedDocument.
+// Invalid documents are counted and dropped. Documents from different tokenizers may be
+// indexed out of submission order. The search server must not be used by anyone else
+// until Drain() returns.
+class IngestPipeline {
+public:
+    explicit IngestPipeline(SearchServer& search_server, size_t tokenizer_count = DEFAULT_TOKENIZER_COUNT, size_t queue_capacity = 1024);
+    // Drains, then stops the stages.
+    ~IngestPipeline();
+    IngestPipeline(const IngestPipeline&) = delete;
+    IngestPipeline& operator=(const IngestPipeline&) = delete;
+
+    // Submit and Drain belong to the reader stage: call them from one thread at a time.
+    void Submit(int document_id, std::string document, DocumentStatus status, std::vector<int> ratings);
+    // Returns once every document submitted so far is indexed or rejected.
+    void Drain();
+
+    IngestPipelineMetrics GetMetrics() const;
+
+    static const size_t DEFAULT_TOKENIZER_COUNT;
+
+private:
+    struct RawDocument {
+        int id = 0;
+        std::string text;
+        DocumentStatus status = DocumentStatus::ACTUAL;
+        std::vector<int> ratings;
+    };
+
+    // A tokenizer may reject a document, so the indexer is told about every one it owns.
+    struct TokenizedItem {
+        bool is_valid = false;
+        TokenizedDocument document;
+    };
+
+    struct StageCounters {
+        std::atomic<size_t> document_count = 0;
+        std::atomic<int64_t> busy_nanoseconds = 0;
+        std::atomic<int64_t> blocked_nanoseconds = 0;
+
+        void Add(IngestStageMetrics& metrics) const;
+    };
+
+    struct Tokenizer {
+        explicit Tokenizer(size_t queue_capacity) : queue(queue_capacity) {
+        }
+
+        SpscQueue<RawDocument> queue;
+        std::atomic<size_t> max_queue_depth = 0;
+        StageCounters counters;
+        std::thread thread;
+    };
+
+    void RunTokenizer(Tokenizer& tokenizer);
+    void RunIndexer();
+    static void UpdateMaxDepth(std::atomic<size_t>& max_depth, size_t depth);
+
+    SearchServer& search_server_;
+    const std::chrono::steady_clock::time_point start_time_ = std::chrono::steady_clock::now();
+    std::vector<std::unique_ptr<Tokenizer>> tokenizers_;
+    MpscQueue<TokenizedItem> indexer_queue_;
+    std::atomic<size_t> max_indexer_queue_depth_ = 0;
+    StageCounters reader_counters_;
+    StageCounters indexer_counters_;
+    size_t next_tokenizer_ = 0;
+    // When the reader last returned from Submit or Drain.
+    std::chrono::steady_clock::time_point reader_resume_time_ = start_time_;
+    std::atomic<size_t> submitted_count_ = 0;
+    std::atomic<size_t> finished_count_ = 0;
+    std::atomic<size_t> rejected_count_ = 0;
+    std::atomic<bool> stopping_ = false;
+    std::thread indexer_thread_;
+};
\ No newline at end of file
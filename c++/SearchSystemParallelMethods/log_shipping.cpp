@@ -0,0 +1,250 @@
+#include "log_shipping.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std::literals;
+
+namespace {
+
+constexpr size_t FRAME_HEADER_SIZE = sizeof(uint8_t) + sizeof(uint64_t) + sizeof(int64_t);
+
+template <typename T>
+void Put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T Get(std::string_view data, size_t position) {
+    T value;
+    std::memcpy(&value, data.data() + position, sizeof(T));
+    return value;
+}
+
+int64_t GetWallClockMicroseconds() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool IsSocket(int fd) {
+    struct stat status;
+    return fd >= 0 && fstat(fd, &status) == 0 && S_ISSOCK(status.st_mode);
+}
+
+} // namespace
+
+FdTransport::FdTransport(int read_fd, int write_fd)
+    : read_fd_(read_fd)
+    , write_fd_(write_fd) {
+    if (pipe2(interrupt_fds_, O_CLOEXEC) != 0) {
+        throw std::runtime_error("Cannot create a pipe"s);
+    }
+}
+
+FdTransport::~FdTransport() {
+    for (const int fd : { read_fd_, write_fd_, interrupt_fds_[0], interrupt_fds_[1] }) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+// Sockets are written with MSG_NOSIGNAL, so a vanished follower is an error rather than a
+// SIGPIPE; a pipe raises SIGPIPE as usual unless the process ignores it.
+void FdTransport::Send(std::string_view data) {
+    const bool socket = IsSocket(write_fd_);
+    while (!data.empty()) {
+        const ssize_t size = socket ? send(write_fd_, data.data(), data.size(), MSG_NOSIGNAL) : write(write_fd_, data.data(), data.size());
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size <= 0) {
+            throw std::runtime_error("Cannot send replication stream"s);
+        }
+        data.remove_prefix(size);
+    }
+}
+
+void FdTransport::CloseSending() {
+    if (write_fd_ >= 0) {
+        close(write_fd_);
+        write_fd_ = -1;
+    }
+}
+
+size_t FdTransport::Receive(char* buffer, size_t capacity) {
+    pollfd fds[2] = { { read_fd_, POLLIN, 0 }, { interrupt_fds_[0], POLLIN, 0 } };
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Cannot receive replication stream"s);
+        }
+        if (fds[1].revents != 0) {
+            return 0;
+        }
+        const ssize_t size = read(read_fd_, buffer, capacity);
+        if (size >= 0) {
+            return size;
+        }
+        if (errno != EINTR && errno != EAGAIN) {
+            throw std::runtime_error("Cannot receive replication stream"s);
+        }
+    }
+}
+
+void FdTransport::Interrupt() {
+    const char byte = 0;
+    while (write(interrupt_fds_[1], &byte, 1) < 0 && errno == EINTR) {
+    }
+}
+
+std::pair<std::unique_ptr<FdTransport>, std::unique_ptr<FdTransport>> FdTransport::MakePipe() {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        throw std::runtime_error("Cannot create a pipe"s);
+    }
+    return { std::make_unique<FdTransport>(-1, fds[1]), std::make_unique<FdTransport>(fds[0], -1) };
+}
+
+std::pair<std::unique_ptr<FdTransport>, std::unique_ptr<FdTransport>> FdTransport::MakeUnixSocketPair() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+        throw std::runtime_error("Cannot create a socket pair"s);
+    }
+    return { std::make_unique<FdTransport>(-1, fds[0]), std::make_unique<FdTransport>(fds[1], -1) };
+}
+
+void AppendReplicationFrame(std::string& out, ReplicationFrameKind kind, uint64_t sequence, int64_t timestamp_us,
+    std::string_view record_payload) {
+    Put(out, static_cast<uint8_t>(kind));
+    Put(out, sequence);
+    Put(out, timestamp_us);
+    if (kind == ReplicationFrameKind::RECORD) {
+        Put(out, static_cast<uint32_t>(record_payload.size()));
+        out += record_payload;
+    }
+}
+
+bool ReadReplicationFrame(std::string_view data, size_t& position, ReplicationFrame& frame) {
+    if (data.size() - position < FRAME_HEADER_SIZE) {
+        return false;
+    }
+    const uint8_t kind = Get<uint8_t>(data, position);
+    if (kind > static_cast<uint8_t>(ReplicationFrameKind::HEARTBEAT)) {
+        throw std::runtime_error("Corrupt replication stream"s);
+    }
+    frame.kind = static_cast<ReplicationFrameKind>(kind);
+    frame.sequence = Get<uint64_t>(data, position + sizeof(uint8_t));
+    frame.timestamp_us = Get<int64_t>(data, position + sizeof(uint8_t) + sizeof(uint64_t));
+    size_t frame_end = position + FRAME_HEADER_SIZE;
+    if (frame.kind == ReplicationFrameKind::RECORD) {
+        if (data.size() - frame_end < sizeof(uint32_t)) {
+            return false;
+        }
+        const uint32_t payload_size = Get<uint32_t>(data, frame_end);
+        frame_end += sizeof(uint32_t);
+        if (data.size() - frame_end < payload_size) {
+            return false;
+        }
+        if (!DecodeWalRecord(data.substr(frame_end, payload_size), frame.record)) {
+            throw std::runtime_error("Corrupt replication stream"s);
+        }
+        frame_end += payload_size;
+    }
+    position = frame_end;
+    return true;
+}
+
+LogShipper::LogShipper(std::unique_ptr<ReplicationTransport> transport, std::chrono::milliseconds heartbeat_interval, size_t max_queued_bytes)
+    : transport_(std::move(transport))
+    , heartbeat_interval_(heartbeat_interval)
+    , max_queued_bytes_(max_queued_bytes)
+    , sender_([this] {
+        RunSender();
+        }) {
+}
+
+LogShipper::~LogShipper() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    sender_wake_up_.notify_all();
+    sender_.join();
+}
+
+uint64_t LogShipper::Ship(const WalRecord& record) {
+    const std::string payload = EncodeWalRecord(record);
+    std::lock_guard lock(mutex_);
+    ++sequence_;
+    if (connected_) {
+        const bool was_empty = buffer_.empty();
+        AppendReplicationFrame(buffer_, ReplicationFrameKind::RECORD, sequence_, GetWallClockMicroseconds(), payload);
+        if (buffer_.size() > max_queued_bytes_) {
+            connected_ = false;
+            std::string().swap(buffer_);
+            sender_wake_up_.notify_one();
+        }
+        else if (was_empty) {
+            sender_wake_up_.notify_one();
+        }
+    }
+    return sequence_;
+}
+
+uint64_t LogShipper::GetShippedSequence() const {
+    std::lock_guard lock(mutex_);
+    return sequence_;
+}
+
+bool LogShipper::IsConnected() const {
+    std::lock_guard lock(mutex_);
+    return connected_;
+}
+
+// A heartbeat is made under the lock with nothing queued, so its sequence is the last change
+// shipped at its time and the follower has every change before it once it reads it.
+void LogShipper::RunSender() {
+    std::unique_lock lock(mutex_);
+    std::string sending;
+    while (true) {
+        sender_wake_up_.wait_for(lock, heartbeat_interval_, [this] {
+            return stopping_ || !connected_ || !buffer_.empty();
+            });
+        if (!connected_) {
+            break;
+        }
+        if (buffer_.empty()) {
+            if (stopping_) {
+                break;
+            }
+            AppendReplicationFrame(buffer_, ReplicationFrameKind::HEARTBEAT, sequence_, GetWallClockMicroseconds());
+        }
+        sending.swap(buffer_);
+        lock.unlock();
+        bool sent = true;
+        try {
+            transport_->Send(sending);
+        }
+        catch (const std::runtime_error&) {
+            sent = false;
+        }
+        sending.clear();
+        lock.lock();
+        if (!sent) {
+            connected_ = false;
+            buffer_.clear();
+            return;
+        }
+    }
+    lock.unlock();
+    transport_->CloseSending();
+}
\ No newline at end of file
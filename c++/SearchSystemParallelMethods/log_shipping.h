@@ -0,0 +1,123 @@
+#pragma once
+
+#include "write_ahead_log.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+// A byte stream from a primary to one follower. Send and Receive are each called by one
+// thread at a time; Interrupt may be called from any thread.
+class ReplicationTransport {
+public:
+    virtual ~ReplicationTransport() = default;
+
+    // Throws std::runtime_error if the stream is broken.
+    virtual void Send(std::string_view data) = 0;
+    // Tells the receiving end no more data follows.
+    virtual void CloseSending() = 0;
+    // Blocks until some data arrives and returns its size, or 0 once the stream has ended or
+    // Interrupt was called.
+    virtual size_t Receive(char* buffer, size_t capacity) = 0;
+    virtual void Interrupt() = 0;
+};
+
+// A transport over file descriptors: a pipe, or a Unix socket, which may also connect two
+// processes forked after the pair was made. Owns and closes its descriptors.
+class FdTransport : public ReplicationTransport {
+public:
+    // Either descriptor may be -1 for a transport that only receives or only sends.
+    FdTransport(int read_fd, int write_fd);
+    ~FdTransport() override;
+    FdTransport(const FdTransport&) = delete;
+    FdTransport& operator=(const FdTransport&) = delete;
+
+    void Send(std::string_view data) override;
+    void CloseSending() override;
+    size_t Receive(char* buffer, size_t capacity) override;
+    void Interrupt() override;
+
+    // The sending end first and the receiving end second.
+    static std::pair<std::unique_ptr<FdTransport>, std::unique_ptr<FdTransport>> MakePipe();
+    static std::pair<std::unique_ptr<FdTransport>, std::unique_ptr<FdTransport>> MakeUnixSocketPair();
+
+private:
+    int read_fd_;
+    int write_fd_;
+    // Written by Interrupt to wake a Receive waiting in poll.
+    int interrupt_fds_[2] = { -1, -1 };
+};
+
+// A frame is its kind, the primary's sequence number and the primary's wall clock time in
+// microseconds when the frame was made, then for a record the record's size and encoding.
+enum class ReplicationFrameKind : uint8_t {
+    RECORD,
+    // No record follows: the primary had shipped up to the frame's sequence at its time.
+    HEARTBEAT,
+};
+
+struct ReplicationFrame {
+    ReplicationFrameKind kind = ReplicationFrameKind::HEARTBEAT;
+    uint64_t sequence = 0;
+    int64_t timestamp_us = 0;
+    WalRecord record;
+};
+
+void AppendReplicationFrame(std::string& out, ReplicationFrameKind kind, uint64_t sequence, int64_t timestamp_us,
+    std::string_view record_payload = {});
+// Reads the frame at position and moves position past it; returns false if data ends inside
+// the frame. Throws std::runtime_error for data that is not a frame.
+bool ReadReplicationFrame(std::string_view data, size_t& position, ReplicationFrame& frame);
+
+// Primary side of log shipping: Ship numbers a change and queues it, and a sender thread
+// writes the queue to the transport. When the primary is idle for heartbeat_interval, the
+// sender writes a heartbeat, so a caught-up follower can tell it is not stale. If the
+// transport breaks, or the follower falls so far behind that more than max_queued_bytes wait
+// to be sent, the shipper drops everything from then on and ends the stream once the send in
+// progress returns: the follower must be seeded again. Thread-safe; changes are numbered in
+// the order Ship is called.
+class LogShipper {
+public:
+    static constexpr size_t DEFAULT_MAX_QUEUED_BYTES = size_t(64) << 20;
+
+    explicit LogShipper(std::unique_ptr<ReplicationTransport> transport,
+        std::chrono::milliseconds heartbeat_interval = std::chrono::milliseconds(10), size_t max_queued_bytes = DEFAULT_MAX_QUEUED_BYTES);
+    // Sends what is queued and ends the stream.
+    ~LogShipper();
+    LogShipper(const LogShipper&) = delete;
+    LogShipper& operator=(const LogShipper&) = delete;
+
+    // Returns the change's sequence number, counted from 1.
+    uint64_t Ship(const WalRecord& record);
+    uint64_t GetShippedSequence() const;
+    bool IsConnected() const;
+
+private:
+    void RunSender();
+
+    const std::unique_ptr<ReplicationTransport> transport_;
+    const std::chrono::milliseconds heartbeat_interval_;
+    const size_t max_queued_bytes_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable sender_wake_up_;
+    std::string buffer_;
+    uint64_t sequence_ = 0;
+    bool connected_ = true;
+    bool stopping_ = false;
+    std::thread sender_;
+};
+
+// How far a follower is behind its primary. The follower has applied every change the
+// primary had made up to staleness ago; a follower that never heard from its primary is
+// infinitely stale.
+struct ReplicationLag {
+    uint64_t applied_sequence = 0;
+    std::chrono::microseconds staleness = std::chrono::microseconds::max();
+};
\ No newline at end of file
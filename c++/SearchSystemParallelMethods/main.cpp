@@ -1,15 +1,64 @@
 #include "process_queries.h"
 
+#include "durable_search_server.h"
+#include "follower_search_server.h"
+#include "index_replica.h"
+#include "ingest_pipeline.h"
 #include "log_duration.h"
+#include "mapped_search_server.h"
+#include "scoring_kernel.h"
+#include "search_daemon.h"
+#include "search_load_client.h"
+#include "segmented_search_server.h"
+#include "shard_coordinator.h"
+#include "shard_server.h"
+#include "sharded_search_server.h"
+#include "unix_socket.h"
+#include "versioned_search_server.h"
 
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
 #include <execution>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <new>
 #include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include <sys/wait.h>
+#include <unistd.h>
+
 using namespace std;
 
+// operator new counts into this while CountQueryAllocations measures the calling thread; every
+// other allocation, on any thread, pays only for reading a null thread-local pointer.
+thread_local size_t* allocation_counter = nullptr;
+
+void* operator new(size_t size) {
+    if (allocation_counter != nullptr) {
+        ++*allocation_counter;
+    }
+    if (void* pointer = malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw bad_alloc();
+}
+
+// Out of line, so the compiler never sees free() inlined against a new-expression.
+__attribute__((noinline)) void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+__attribute__((noinline)) void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
 string GenerateWord(mt19937& generator, int max_length) {
     const int length = uniform_int_distribution(1, max_length)(generator);
     string word;
@@ -53,21 +102,846 @@ vector<string> GenerateQueries(mt19937& generator, const vector<string>& diction
     return queries;
 }
 
-template <typename ExecutionPolicy>
-void Test(string_view mark, const SearchServer& search_server, const vector<string>& queries, ExecutionPolicy&& policy) {
+template <typename Scorer = TfIdfScorer, typename Server, typename ExecutionPolicy>
+void Test(string_view mark, const Server& search_server, const vector<string>& queries, ExecutionPolicy&& policy) {
     LOG_DURATION(mark);
     double total_relevance = 0;
     for (const string_view query : queries) {
-        for (const auto& document : search_server.FindTopDocuments(policy, query)) {
+        for (const auto& document : search_server.template FindTopDocuments<Scorer>(policy, query)) {
+            total_relevance += document.relevance;
+        }
+    }
+    cout << total_relevance << endl;
+}
+
+template <typename ExecutionPolicy>
+void TestCount(string_view mark, const SearchServer& search_server, const vector<string>& queries, ExecutionPolicy&& policy) {
+    LOG_DURATION(mark);
+    long long total_matches = 0;
+    for (const string_view query : queries) {
+        total_matches += search_server.CountMatches(policy, query);
+    }
+    cout << total_matches << endl;
+}
+
+template <typename QueryProcessor>
+void TestProcessQueries(string_view mark, const SearchServer& search_server, const vector<string>& queries, QueryProcessor process_queries) {
+    LOG_DURATION(mark);
+    double total_relevance = 0;
+    for (const auto& documents : process_queries(search_server, queries)) {
+        for (const auto& document : documents) {
             total_relevance += document.relevance;
         }
     }
     cout << total_relevance << endl;
 }
 
+template <typename Documents>
+double SumRelevance(const Documents& documents) {
+    double total_relevance = 0;
+    for (const auto& document : documents) {
+        total_relevance += document.relevance;
+    }
+    return total_relevance;
+}
+
+// Queries drawn from 50 words share most of them, which is the case batching is for.
+void CompareBatchOnOverlappingQueries(const SearchServer& search_server, const vector<string>& dictionary) {
+    mt19937 generator;
+    const vector<string> shared_words(dictionary.begin() + 1, dictionary.begin() + 51);
+    const auto queries = GenerateQueries(generator, shared_words, 100, 20);
+    TestProcessQueries("overlapping ProcessQueries"s, search_server, queries, [](const SearchServer& search_server, const vector<string>& queries) {
+        return ProcessQueries(search_server, queries);
+        });
+    TestProcessQueries("overlapping ProcessQueriesBatched"s, search_server, queries, ProcessQueriesBatched);
+}
+
+void TestJoinedResults(const SearchServer& search_server, const vector<string>& queries) {
+    {
+        LOG_DURATION("ProcessQueriesJoined"s);
+        cout << SumRelevance(ProcessQueriesJoined(search_server, queries)) << endl;
+    }
+    {
+        LOG_DURATION("ProcessQueriesFlat"s);
+        cout << SumRelevance(ProcessQueriesFlat(search_server, queries).documents) << endl;
+    }
+    {
+        LOG_DURATION("ProcessQueriesStreamed"s);
+        double total_relevance = 0;
+        ProcessQueriesStreamed(search_server, queries, [&total_relevance](size_t, const vector<Document>& documents) {
+            total_relevance += SumRelevance(documents);
+            });
+        cout << total_relevance << endl;
+    }
+}
+
+// The first pass lets the per-thread arenas grow; the second is what a steady state query costs.
+void CountQueryAllocations(const SearchServer& search_server, const vector<string>& queries) {
+    for (int pass = 0; pass < 2; ++pass) {
+        size_t allocation_count = 0;
+        allocation_counter = &allocation_count;
+        for (const string_view query : queries) {
+            search_server.FindTopDocuments(query);
+        }
+        allocation_counter = nullptr;
+        cout << "allocations per query, pass "s << pass << ": "s << allocation_count * 1.0 / queries.size() << endl;
+    }
+}
+
+void BenchmarkScoringKernels(mt19937& generator) {
+    const size_t slot_count = 1'000'000;
+    const int repeat_count = 20;
+
+    vector<uint32_t> slots;
+    vector<double> term_freqs;
+    for (size_t slot = 0; slot < slot_count; ++slot) {
+        if (uniform_int_distribution(0, 1)(generator) == 1) {
+            slots.push_back(static_cast<uint32_t>(slot));
+            term_freqs.push_back(uniform_real_distribution<>(0, 1)(generator));
+        }
+    }
+
+    for (const ScoringKernel kernel : { ScoringKernel::SCALAR, ScoringKernel::AVX2, ScoringKernel::AVX512 }) {
+        if (!IsScoringKernelSupported(kernel)) {
+            continue;
+        }
+        vector<double> scores(slot_count, UNMATCHED_SCORE);
+        const auto start_time = chrono::steady_clock::now();
+        for (int i = 0; i < repeat_count; ++i) {
+            AccumulateScores(kernel, slots.data(), term_freqs.data(), slots.size(), 0.5, scores.data());
+        }
+        const chrono::duration<double> elapsed = chrono::steady_clock::now() - start_time;
+        cout << GetScoringKernelName(kernel) << " kernel: "s
+            << slots.size() * repeat_count / elapsed.count() / 1e6 << " M postings/s per core"s << endl;
+    }
+
+    vector<double> scores(slot_count, UNMATCHED_SCORE);
+    AccumulateScores(slots.data(), term_freqs.data(), slots.size(), 0.5, scores.data());
+    vector<DocumentStatus> statuses(slot_count);
+    vector<int> ratings(slot_count);
+    for (size_t slot = 0; slot < slot_count; ++slot) {
+        statuses[slot] = static_cast<DocumentStatus>(uniform_int_distribution(0, 3)(generator));
+        ratings[slot] = uniform_int_distribution(-5, 5)(generator);
+    }
+    const DocumentStatusPredicate predicate{ DocumentStatus::ACTUAL, 1 };
+    vector<uint32_t> matched_slots;
+    const auto start_time = chrono::steady_clock::now();
+    for (int i = 0; i < repeat_count; ++i) {
+        matched_slots.clear();
+        SelectMatchedSlots(scores.data(), statuses.data(), ratings.data(), slot_count, predicate.status, predicate.min_rating, matched_slots);
+    }
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start_time;
+    size_t expected_count = 0;
+    for (size_t slot = 0; slot < slot_count; ++slot) {
+        expected_count += !signbit(scores[slot]) && predicate(0, statuses[slot], ratings[slot]);
+    }
+    cout << "status/rating mask: "s << slot_count * repeat_count / elapsed.count() / 1e6 << " M slots/s per core, "s
+        << (matched_slots.size() == expected_count ? "same"s : "DIFFERENT"s) << " matches as the predicate"s << endl;
+}
+
+// Every round adds documents and removes them again; compaction keeps the columns from growing.
+void TestAddRemoveCycles(const vector<string>& dictionary, const vector<string>& documents, const vector<string>& queries) {
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+    const int round_count = 6;
+    const int round_size = 5000;
+    for (int round = 0; round < round_count; ++round) {
+        const int first_id = static_cast<int>(documents.size()) + round * round_size;
+        for (int i = 0; i < round_size; ++i) {
+            search_server.AddDocument(first_id + i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+        for (int i = 0; i < round_size; ++i) {
+            search_server.RemoveDocument(first_id + i);
+        }
+        const IndexMemoryStats stats = search_server.GetIndexMemoryStats();
+        cout << "add/remove round "s << round + 1 << ": "s << stats.document_column_bytes + stats.forward_index_bytes << " column and forward index bytes"s << endl;
+    }
+    Test("add/remove cycles"s, search_server, queries, execution::seq);
+}
+
+void CompareTermFreqStorage(const vector<string>& dictionary, const vector<string>& documents, const vector<string>& queries) {
+    for (const auto& [storage, name] : { pair{ TermFreqStorage::DOUBLE, "double"s }, pair{ TermFreqStorage::FLOAT, "float"s }, pair{ TermFreqStorage::COUNT, "count"s } }) {
+        SearchServer search_server(dictionary[0], storage);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+        const IndexMemoryStats stats = search_server.GetIndexMemoryStats();
+        cout << name << " storage: "s << stats.posting_bytes << " posting bytes, "s
+            << stats.posting_bytes * 1.0 / stats.posting_count << " bytes per posting"s << endl;
+        Test(name, search_server, queries, execution::seq);
+    }
+}
+
 #define TEST(policy) Test(#policy, search_server, queries, execution::policy)
+#define TEST_SCORER(scorer, policy) Test<scorer>(#scorer " " #policy, search_server, queries, execution::policy)
+
+void CompareIndexHugePages(const vector<string>& dictionary, const vector<string>& documents, const vector<string>& queries) {
+    for (const auto& [huge_pages, name] : { pair{ IndexHugePages::NONE, "4k pages"s }, pair{ IndexHugePages::TRANSPARENT, "transparent huge pages"s },
+        pair{ IndexHugePages::EXPLICIT, "explicit huge pages"s } }) {
+        SearchServer search_server(dictionary[0], TermFreqStorage::DOUBLE, huge_pages);
+        {
+            LOG_DURATION(name + " ingest"s);
+            for (size_t i = 0; i < documents.size(); ++i) {
+                search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+            }
+        }
+        const IndexArenaStats arena = search_server.GetIndexMemoryStats().arena;
+        cout << name << ": "s << arena.reserved_bytes << " arena bytes in "s << arena.slab_count << " slabs and "s
+            << arena.large_block_count << " large blocks, "s << arena.GetUtilization() * 100 << "% used, "s
+            << arena.huge_page_bytes << " huge page bytes"s << endl;
+        Test(name, search_server, queries, execution::seq);
+    }
+}
+
+template <typename ExecutionPolicy>
+void TestBulkIngest(string_view mark, const string& stop_words, const vector<DocumentInput>& inputs, const vector<string>& queries, ExecutionPolicy&& policy) {
+    SearchServer search_server(stop_words);
+    {
+        LOG_DURATION(mark);
+        search_server.AddDocuments(policy, inputs);
+    }
+    Test(mark, search_server, queries, execution::seq);
+}
+
+void CompareBulkIngest(const vector<string>& dictionary, const vector<string>& documents, const vector<string>& queries, ThreadPool& pool) {
+    {
+        SearchServer search_server(dictionary[0]);
+        LOG_DURATION("AddDocument loop"s);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+    }
+    vector<DocumentInput> inputs;
+    inputs.reserve(documents.size());
+    for (size_t i = 0; i < documents.size(); ++i) {
+        inputs.push_back({ static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 } });
+    }
+    TestBulkIngest("AddDocuments seq"s, dictionary[0], inputs, queries, execution::seq);
+    TestBulkIngest("AddDocuments par"s, dictionary[0], inputs, queries, execution::par);
+    TestBulkIngest("AddDocuments pool"s, dictionary[0], inputs, queries, pool);
+}
+
+void PrintStageMetrics(string_view stage, const IngestStageMetrics& metrics, chrono::nanoseconds elapsed_time) {
+    cout << stage << ": "s << metrics.document_count << " documents, "s << static_cast<int>(metrics.GetThroughput()) << " documents/s busy, "s
+        << metrics.busy_time * 100 / elapsed_time << "% busy, "s << metrics.blocked_time * 100 / elapsed_time << "% blocked"s << endl;
+}
+
+void TestIngestPipeline(const vector<string>& dictionary, const vector<string>& documents, const vector<string>& queries) {
+    SearchServer search_server(dictionary[0]);
+    {
+        LOG_DURATION("ingest pipeline"s);
+        IngestPipeline pipeline(search_server);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            pipeline.Submit(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+        pipeline.Drain();
+
+        const IngestPipelineMetrics metrics = pipeline.GetMetrics();
+        PrintStageMetrics("reader"s, metrics.reader, metrics.elapsed_time);
+        PrintStageMetrics("tokenizer"s, metrics.tokenizer, metrics.elapsed_time);
+        PrintStageMetrics("indexer"s, metrics.indexer, metrics.elapsed_time);
+        for (const IngestQueueMetrics& queue : metrics.tokenizer_queues) {
+            cout << "tokenizer queue: max depth "s << queue.max_depth << " of "s << queue.capacity << endl;
+        }
+        cout << "indexer queue: max depth "s << metrics.indexer_queue.max_depth << " of "s << metrics.indexer_queue.capacity
+            << ", "s << metrics.rejected_document_count << " rejected"s << endl;
+    }
+    Test("ingest pipeline"s, search_server, queries, execution::seq);
+}
+
+// Every writer adds its share of the documents and then races the others for the same ids,
+// which exactly one of them may win. Whatever the writer count, the index must come out
+// the same as one built sequentially.
+void TestConcurrentWriters(const vector<string>& dictionary, const vector<string>& documents, const vector<string>& queries) {
+    const size_t contested_count = 100;
+    SearchServer reference_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        reference_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+    for (size_t i = 0; i < contested_count; ++i) {
+        reference_server.AddDocument(documents.size() + i, documents[i], DocumentStatus::IRRELEVANT, { 1 });
+    }
+    const auto is_same = [](const vector<Document>& lhs, const vector<Document>& rhs) {
+        return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& lhs, const Document& rhs) {
+            return lhs.id == rhs.id && lhs.relevance == rhs.relevance && lhs.rating == rhs.rating;
+            });
+    };
+
+    for (const size_t writer_count : { 1, 2, 4, 8 }) {
+        SearchServer search_server(dictionary[0]);
+        atomic<size_t> duplicate_wins = 0;
+        {
+            LOG_DURATION(to_string(writer_count) + " writers"s);
+            vector<thread> writers;
+            for (size_t writer = 0; writer < writer_count; ++writer) {
+                writers.emplace_back([&, writer] {
+                    for (size_t i = writer; i < documents.size(); i += writer_count) {
+                        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+                    }
+                    for (size_t i = 0; i < contested_count; ++i) {
+                        try {
+                            search_server.AddDocument(documents.size() + i, documents[i], DocumentStatus::IRRELEVANT, { 1 });
+                            ++duplicate_wins;
+                        }
+                        catch (const invalid_argument&) {
+                        }
+                    }
+                    });
+            }
+            for (thread& writer : writers) {
+                writer.join();
+            }
+        }
+        size_t same_count = 0;
+        for (const string& query : queries) {
+            same_count += is_same(search_server.FindTopDocuments(query), reference_server.FindTopDocuments(query))
+                && is_same(search_server.FindTopDocuments(query, DocumentStatus::IRRELEVANT), reference_server.FindTopDocuments(query, DocumentStatus::IRRELEVANT));
+        }
+        cout << writer_count << " writers: "s << search_server.GetDocumentCount() << " documents, "s << duplicate_wins << " contested ids won, "s
+            << same_count << " of "s << queries.size() << " queries identical to a sequential index"s << endl;
+        if (search_server.GetDocumentCount() != reference_server.GetDocumentCount() || duplicate_wins != contested_count || same_count != queries.size()) {
+            throw runtime_error(to_string(writer_count) + " concurrent writers built a different index than one writer"s);
+        }
+        Test(to_string(writer_count) + " writers"s, search_server, queries, execution::seq);
+    }
+}
+
+// Mean and worst AddDocument latency for each fifth of the documents.
+template <typename Server>
+void MeasureIngestLatency(string_view mark, Server& search_server, const vector<string>& documents) {
+    const size_t chunk_size = documents.size() / 5;
+    for (size_t begin = 0; begin + chunk_size <= documents.size(); begin += chunk_size) {
+        chrono::nanoseconds total_latency{};
+        chrono::nanoseconds max_latency{};
+        for (size_t i = begin; i < begin + chunk_size; ++i) {
+            const auto start = chrono::steady_clock::now();
+            search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+            const auto latency = chrono::steady_clock::now() - start;
+            total_latency += latency;
+            max_latency = max(max_latency, latency);
+        }
+        cout << mark << " ingest of documents "s << begin << ".."s << begin + chunk_size << ": mean "s
+            << chrono::duration_cast<chrono::microseconds>(total_latency).count() / chunk_size << " us, max "s
+            << chrono::duration_cast<chrono::microseconds>(max_latency).count() << " us"s << endl;
+    }
+}
 
-int main() {
+void CompareSegmentedIndex(const vector<string>& dictionary, const vector<string>& documents, const vector<string>& queries) {
+    {
+        SearchServer search_server(dictionary[0]);
+        MeasureIngestLatency("single index"s, search_server, documents);
+    }
+    SegmentedSearchServer search_server(dictionary[0], SegmentMergePolicy{ 1000, 4 });
+    MeasureIngestLatency("segmented index"s, search_server, documents);
+    search_server.WaitForMerges();
+    cout << "segments:"s;
+    for (const int size : search_server.GetSegmentSizes()) {
+        cout << ' ' << size;
+    }
+    cout << endl;
+
+    {
+        LOG_DURATION("segmented index"s);
+        double total_relevance = 0;
+        for (const string_view query : queries) {
+            for (const auto& document : search_server.FindTopDocuments(query)) {
+                total_relevance += document.relevance;
+            }
+        }
+        cout << total_relevance << endl;
+    }
+
+    // The only document with "cat" is removed from a sealed segment, whose postings still hold it:
+    // the word has no live document left, so the query must match nothing rather than fail.
+    SegmentedSearchServer tombstoned_server("and with"s, SegmentMergePolicy{ 2, 4 });
+    tombstoned_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+    tombstoned_server.AddDocument(2, "black dog"s, DocumentStatus::ACTUAL, { 2 });
+    tombstoned_server.AddDocument(3, "grey dog"s, DocumentStatus::ACTUAL, { 3 });
+    tombstoned_server.RemoveDocument(1);
+    cout << "removed from a sealed segment: "s << tombstoned_server.FindTopDocuments("cat"s).size() << " documents for \"cat\", "s
+        << tombstoned_server.FindTopDocuments("white dog"s).size() << " for \"white dog\""s << endl;
+}
+
+// Readers query snapshots while the writer removes and re-adds documents; every snapshot
+// must see a whole version, so the document count never drops below the untouched part.
+void TestConcurrentUpdates(const vector<string>& dictionary, const vector<string>& documents, const vector<string>& queries) {
+    VersionedSearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+    const int updated_count = 200;
+
+    atomic<bool> writing = true;
+    atomic<size_t> query_count = 0;
+    atomic<size_t> torn_count = 0;
+    vector<thread> readers;
+    for (int i = 0; i < 2; ++i) {
+        readers.emplace_back([&] {
+            for (size_t query_index = 0; writing; query_index = (query_index + 1) % queries.size()) {
+                const auto snapshot = search_server.GetSnapshot();
+                if (snapshot->GetDocumentCount() < static_cast<int>(documents.size()) - updated_count) {
+                    ++torn_count;
+                }
+                snapshot->FindTopDocuments(queries[query_index]);
+                ++query_count;
+            }
+            });
+    }
+    {
+        LOG_DURATION("concurrent updates"s);
+        for (int i = 0; i < updated_count; ++i) {
+            search_server.RemoveDocument(i);
+        }
+        for (int i = 0; i < updated_count; ++i) {
+            search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+    }
+    writing = false;
+    for (thread& reader : readers) {
+        reader.join();
+    }
+    cout << "concurrent updates: version "s << search_server.GetVersion() << ", "s << query_count << " queries served, "s
+        << torn_count << " torn snapshots"s << endl;
+}
+
+// OpenMapped only checks the header, so its time does not grow with the index.
+void CompareMappedIndex(const SearchServer& search_server, const vector<string>& queries) {
+    const string path = (filesystem::temp_directory_path() / "search_server_index.bin"s).string();
+    {
+        LOG_DURATION("Save"s);
+        search_server.Save(path);
+    }
+    const auto open_start = chrono::steady_clock::now();
+    const MappedSearchServer mapped_server = SearchServer::OpenMapped(path);
+    cout << "OpenMapped: "s << chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - open_start).count() << " us for "s
+        << mapped_server.GetFileSize() << " bytes, "s << mapped_server.GetDocumentCount() << " documents"s << endl;
+    Test("mapped seq"s, mapped_server, queries, execution::seq);
+    Test("mapped par"s, mapped_server, queries, execution::par);
+    Test<Bm25Scorer>("mapped Bm25Scorer seq"s, mapped_server, queries, execution::seq);
+    filesystem::remove(path);
+}
+
+// Four writers per policy; records per write shows how much group commit batched.
+void CompareWalSyncPolicies(const vector<string>& dictionary, const vector<string>& documents, const vector<string>& queries) {
+    const filesystem::path directory = filesystem::temp_directory_path() / "search_server_wal"s;
+    for (const auto& [sync_policy, name] : { pair{ WalSyncPolicy::EVERY_OPERATION, "sync every operation"s },
+        pair{ WalSyncPolicy::INTERVAL, "sync every 10 ms"s }, pair{ WalSyncPolicy::NEVER, "never sync"s } }) {
+        filesystem::remove_all(directory);
+        {
+            DurableSearchServer search_server(directory.string(), dictionary[0], { sync_policy });
+            {
+                LOG_DURATION(name);
+                vector<thread> writers;
+                for (size_t writer = 0; writer < 4; ++writer) {
+                    writers.emplace_back([&, writer] {
+                        for (size_t i = writer; i < documents.size(); i += 4) {
+                            search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+                        }
+                        });
+                }
+                for (thread& writer : writers) {
+                    writer.join();
+                }
+            }
+            const WalStats stats = search_server.GetWalStats();
+            cout << name << ": "s << stats.record_count << " records in "s << stats.write_count << " writes and "s << stats.sync_count << " syncs"s << endl;
+        }
+        DurableSearchServer recovered_server(directory.string(), dictionary[0], { sync_policy });
+        cout << name << ": recovered "s << recovered_server.GetRecoveredRecordCount() << " records"s << endl;
+        Test(name + " recovered"s, recovered_server, queries, execution::seq);
+    }
+    filesystem::remove_all(directory);
+}
+
+// Query latency while a writer keeps adding documents, first alone and then with checkpoints
+// running back to back. The fork pause is how long StartCheckpoint held queries and writes.
+void MeasureCheckpointLatency(const vector<string>& dictionary, const vector<string>& documents, const vector<string>& queries) {
+    const filesystem::path directory = filesystem::temp_directory_path() / "search_server_checkpoint"s;
+    filesystem::remove_all(directory);
+    DurableSearchServer search_server(directory.string(), dictionary[0], { WalSyncPolicy::NEVER });
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+
+    int next_document_id = static_cast<int>(documents.size());
+    for (const bool checkpointing : { false, true }) {
+        atomic<bool> done = false;
+        thread writer([&] {
+            for (size_t i = 0; !done; i = (i + 1) % documents.size()) {
+                search_server.AddDocument(next_document_id++, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+                this_thread::sleep_for(200us);
+            }
+            });
+        size_t checkpoint_count = 0;
+        chrono::nanoseconds max_fork_pause{};
+        thread checkpointer([&] {
+            while (checkpointing && !done) {
+                const auto start = chrono::steady_clock::now();
+                search_server.StartCheckpoint();
+                max_fork_pause = max(max_fork_pause, chrono::steady_clock::now() - start);
+                search_server.WaitForCheckpoint();
+                ++checkpoint_count;
+            }
+            });
+
+        vector<chrono::nanoseconds> latencies;
+        for (int round = 0; round < 20; ++round) {
+            for (const string& query : queries) {
+                const auto start = chrono::steady_clock::now();
+                search_server.FindTopDocuments(query);
+                latencies.push_back(chrono::steady_clock::now() - start);
+            }
+        }
+        done = true;
+        writer.join();
+        checkpointer.join();
+
+        sort(latencies.begin(), latencies.end());
+        const auto to_us = [](chrono::nanoseconds duration) {
+            return chrono::duration_cast<chrono::microseconds>(duration).count();
+        };
+        cout << (checkpointing ? "background checkpoints"s : "no checkpoint"s) << ": query p50 "s << to_us(latencies[latencies.size() / 2])
+            << " us, p99 "s << to_us(latencies[latencies.size() * 99 / 100]) << " us, max "s << to_us(latencies.back()) << " us"s;
+        if (checkpointing) {
+            cout << ", "s << checkpoint_count << " checkpoints, fork pause up to "s << to_us(max_fork_pause) << " us"s;
+        }
+        cout << endl;
+    }
+    filesystem::remove_all(directory);
+}
+
+// Rss and Pss of the mapped index files in this process: Pss splits each shared page between
+// the processes mapping it, so with N readers it is about Rss / N.
+pair<size_t, size_t> GetMappedIndexMemoryKb() {
+    ifstream smaps("/proc/self/smaps"s);
+    size_t rss_kb = 0;
+    size_t pss_kb = 0;
+    bool in_index = false;
+    for (string line; getline(smaps, line);) {
+        const size_t colon = line.find(':');
+        if (colon == string::npos || line.find(' ') < colon) {
+            in_index = line.find("/index-"s) != string::npos;
+        }
+        else if (in_index && line.compare(0, colon, "Rss"s) == 0) {
+            rss_kb += stoull(line.substr(colon + 1));
+        }
+        else if (in_index && line.compare(0, colon, "Pss"s) == 0) {
+            pss_kb += stoull(line.substr(colon + 1));
+        }
+    }
+    return { rss_kb, pss_kb };
+}
+
+// Four reader processes serve one published directory while the parent publishes a second
+// generation with the first thousand documents removed. Each reader checks every query pass
+// against the relevance sum of the generation it pinned, so a torn swap would show.
+void TestReplicaProcesses(const vector<string>& dictionary, const vector<string>& documents, const vector<string>& queries) {
+    const filesystem::path directory = filesystem::temp_directory_path() / "search_server_replicas"s;
+    filesystem::remove_all(directory);
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+    IndexPublisher publisher(directory.string());
+    publisher.Publish(search_server);
+    vector<double> expected_relevance = { 0 };
+    for (int generation = 1; generation <= 2; ++generation) {
+        double total_relevance = 0;
+        for (const string& query : queries) {
+            total_relevance += SumRelevance(search_server.FindTopDocuments(query));
+        }
+        expected_relevance.push_back(total_relevance);
+        if (generation == 1) {
+            for (int document_id = 0; document_id < 1000; ++document_id) {
+                search_server.RemoveDocument(document_id);
+            }
+        }
+    }
+
+    LOG_DURATION("replica processes"s);
+    ReplicaProcessPool pool(directory.string(), 4, [&](IndexReplica& replica, size_t worker_index) {
+        size_t pass_count = 0;
+        size_t mismatch_count = 0;
+        const auto deadline = chrono::steady_clock::now() + 10s;
+        while (chrono::steady_clock::now() < deadline) {
+            const uint64_t generation = replica.GetGeneration();
+            const auto index = replica.GetIndex();
+            double total_relevance = 0;
+            for (const string& query : queries) {
+                total_relevance += SumRelevance(index->FindTopDocuments(query));
+            }
+            mismatch_count += abs(total_relevance - expected_relevance[generation]) > 1e-6 ? 1 : 0;
+            ++pass_count;
+            if (generation == 2) {
+                break;
+            }
+        }
+        const auto [rss_kb, pss_kb] = GetMappedIndexMemoryKb();
+        const string line = "replica "s + to_string(worker_index) + ": generation "s + to_string(replica.GetGeneration()) + " after "s
+            + to_string(pass_count) + " passes, "s + to_string(mismatch_count) + " mismatches, index Rss "s + to_string(rss_kb)
+            + " kB, Pss "s + to_string(pss_kb) + " kB\n"s;
+        cout << line << flush;
+        return replica.GetGeneration() == 2 && mismatch_count == 0 ? 0 : 1;
+        });
+    this_thread::sleep_for(300ms);
+    publisher.Publish(search_server);
+    const vector<int> exit_codes = pool.Wait();
+    cout << "replica processes: "s << count(exit_codes.begin(), exit_codes.end(), 0) << " of "s << exit_codes.size() << " saw generation 2 with no mismatches"s << endl;
+    filesystem::remove_all(directory);
+}
+
+// A primary ships its changes to one follower over a pipe and one over a Unix socket while a
+// writer keeps adding documents and then removes a thousand. Each query goes to a follower
+// fresher than 20 ms, if there is one, and to the primary otherwise. Once the followers have
+// caught up, they must answer exactly as the primary does.
+void TestLogShipping(const vector<string>& dictionary, const vector<string>& documents, const vector<string>& queries) {
+    const filesystem::path directory = filesystem::temp_directory_path() / "search_server_primary"s;
+    filesystem::remove_all(directory);
+    DurableSearchServer primary(directory.string(), dictionary[0], { WalSyncPolicy::NEVER });
+    auto [pipe_sender, pipe_receiver] = FdTransport::MakePipe();
+    auto [socket_sender, socket_receiver] = FdTransport::MakeUnixSocketPair();
+    const auto pipe_shipper = make_shared<LogShipper>(move(pipe_sender));
+    const auto socket_shipper = make_shared<LogShipper>(move(socket_sender));
+    primary.AddLogShipper(pipe_shipper);
+    primary.AddLogShipper(socket_shipper);
+    FollowerSearchServer pipe_follower(dictionary[0], move(pipe_receiver));
+    FollowerSearchServer socket_follower(dictionary[0], move(socket_receiver));
+
+    atomic<bool> done = false;
+    thread writer([&] {
+        for (size_t i = 0; i < documents.size(); ++i) {
+            primary.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+            this_thread::sleep_for(50us);
+        }
+        for (int document_id = 0; document_id < 1000; ++document_id) {
+            primary.RemoveDocument(document_id);
+        }
+        done = true;
+        });
+    const auto max_staleness = 20ms;
+    size_t follower_query_count = 0;
+    size_t primary_query_count = 0;
+    chrono::microseconds max_seen_staleness{};
+    while (!done) {
+        for (const string& query : queries) {
+            const ReplicationLag lag = socket_follower.GetReplicationLag();
+            if (lag.staleness != chrono::microseconds::max()) {
+                max_seen_staleness = max(max_seen_staleness, lag.staleness);
+            }
+            if (pipe_follower.IsFresherThan(max_staleness)) {
+                pipe_follower.FindTopDocuments(query);
+                ++follower_query_count;
+            }
+            else if (socket_follower.IsFresherThan(max_staleness)) {
+                socket_follower.FindTopDocuments(query);
+                ++follower_query_count;
+            }
+            else {
+                primary.FindTopDocuments(query);
+                ++primary_query_count;
+            }
+        }
+    }
+    writer.join();
+    cout << "log shipping: "s << follower_query_count << " queries served by followers, "s << primary_query_count
+        << " by the primary, follower staleness up to "s << max_seen_staleness.count() << " us"s << endl;
+
+    const bool caught_up = pipe_follower.WaitForSequence(pipe_shipper->GetShippedSequence(), 5000ms)
+        && socket_follower.WaitForSequence(socket_shipper->GetShippedSequence(), 5000ms);
+    cout << "log shipping: followers "s << (caught_up ? "caught up"s : "did not catch up"s) << " at sequence "s << pipe_shipper->GetShippedSequence()
+        << ", "s << pipe_follower.GetDocumentCount() << " and "s << socket_follower.GetDocumentCount() << " documents"s << endl;
+    Test("primary"s, primary, queries, execution::seq);
+    Test("pipe follower"s, pipe_follower, queries, execution::seq);
+    Test("socket follower"s, socket_follower, queries, execution::seq);
+    filesystem::remove_all(directory);
+}
+
+// A follower that never reads: once more than the cap is queued for it, the shipper must
+// disconnect it and free the queue instead of holding every later change in memory.
+void TestSlowFollower(const vector<string>& documents) {
+    auto [sender, receiver] = FdTransport::MakeUnixSocketPair();
+    const size_t max_queued_bytes = size_t(1) << 20;
+    auto shipper = make_unique<LogShipper>(move(sender), 10ms, max_queued_bytes);
+    size_t shipped_bytes = 0;
+    for (size_t i = 0; i < documents.size() && shipper->IsConnected(); ++i) {
+        shipper->Ship({ WalRecord::Type::ADD_DOCUMENT, static_cast<int>(i), DocumentStatus::ACTUAL, { 1, 2, 3 }, documents[i] });
+        shipped_bytes += documents[i].size();
+    }
+    cout << "slow follower: "s << (shipper->IsConnected() ? "still connected"s : "disconnected"s) << " after "s << shipper->GetShippedSequence()
+        << " changes, "s << shipped_bytes / 1024 << " KiB of text"s << endl;
+    // The sender may be blocked writing to the full socket; closing the receiving end breaks that write.
+    receiver.reset();
+    shipper.reset();
+}
+
+// Every query must give the same documents with the same relevance from the sharded index as
+// from one SearchServer, before and after removing a thousand documents.
+void CompareShardedIndex(const vector<string>& dictionary, const vector<string>& documents, const vector<string>& queries) {
+    SearchServer single_server(dictionary[0]);
+    ShardedSearchServer sharded_server(dictionary[0], 4);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        single_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        sharded_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+    const auto is_same = [](const vector<Document>& lhs, const vector<Document>& rhs) {
+        return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& lhs, const Document& rhs) {
+            return lhs.id == rhs.id && lhs.relevance == rhs.relevance && lhs.rating == rhs.rating;
+            });
+    };
+    for (const bool removed : { false, true }) {
+        if (removed) {
+            for (int document_id = 0; document_id < 1000; ++document_id) {
+                single_server.RemoveDocument(document_id);
+                sharded_server.RemoveDocument(document_id);
+            }
+        }
+        const PageRequest page{ 2, 10 };
+        size_t same_count = 0;
+        for (const string& query : queries) {
+            const bool same = is_same(single_server.FindTopDocuments(query), sharded_server.FindTopDocuments(execution::par, query))
+                && is_same(single_server.FindTopDocuments<Bm25Scorer>(execution::seq, query), sharded_server.FindTopDocuments<Bm25Scorer>(execution::seq, query))
+                && is_same(single_server.FindTopDocuments(execution::seq, query, DocumentStatusPredicate{ DocumentStatus::ACTUAL }, page),
+                    sharded_server.FindTopDocuments(execution::seq, query, DocumentStatusPredicate{ DocumentStatus::ACTUAL }, page))
+                && single_server.MatchDocument(query, 1234) == sharded_server.MatchDocument(query, 1234);
+            same_count += same ? 1 : 0;
+        }
+        cout << "sharded"s << (removed ? " after removals"s : ""s) << ": "s << same_count << " of "s << queries.size() << " queries identical"s << endl;
+    }
+    Test("single seq"s, single_server, queries, execution::seq);
+    Test("sharded seq"s, sharded_server, queries, execution::seq);
+    Test("sharded par"s, sharded_server, queries, execution::par);
+}
+
+// Two shards with two replicas each, every replica a process of its own. The preferred replica
+// of shard 1 answers 30 ms late: hedging keeps queries fast, without it they wait for the slow
+// replica, and with a deadline shorter than its delay the results lack shard 1.
+void TestShardCoordinator(const SearchServer& search_server, const vector<string>& dictionary, const vector<string>& documents,
+    const vector<string>& queries) {
+    const filesystem::path directory = filesystem::temp_directory_path() / "search_server_shards"s;
+    filesystem::remove_all(directory);
+    filesystem::create_directories(directory);
+    const size_t shard_count = 2;
+    vector<vector<string>> shard_replicas(shard_count);
+    vector<pid_t> server_pids;
+    for (size_t shard = 0; shard < shard_count; ++shard) {
+        for (size_t replica = 0; replica < 2; ++replica) {
+            const string socket_path = (directory / ("shard-"s + to_string(shard) + "-"s + to_string(replica) + ".sock"s)).string();
+            shard_replicas[shard].push_back(socket_path);
+            const pid_t pid = fork();
+            if (pid == 0) {
+                SearchServer shard_index(dictionary[0]);
+                for (size_t i = shard; i < documents.size(); i += shard_count) {
+                    shard_index.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+                }
+                ShardServer server(shard_index, socket_path, { shard == 1 && replica == 0 ? 30ms : 0ms });
+                server.Serve();
+                _exit(0);
+            }
+            server_pids.push_back(pid);
+        }
+    }
+    for (const auto& replicas : shard_replicas) {
+        for (const string& socket_path : replicas) {
+            while (!filesystem::exists(socket_path)) {
+                this_thread::sleep_for(1ms);
+            }
+        }
+    }
+
+    for (const auto& [name, options] : { pair{ "hedged"s, ShardCoordinatorOptions{ 100ms, 5ms } },
+        pair{ "not hedged"s, ShardCoordinatorOptions{ 100ms, 1000ms } }, pair{ "20 ms deadline"s, ShardCoordinatorOptions{ 20ms, 1000ms } } }) {
+        ShardCoordinator coordinator(shard_replicas, options);
+        size_t identical_count = 0;
+        size_t partial_count = 0;
+        size_t hedged_request_count = 0;
+        vector<chrono::nanoseconds> latencies;
+        for (const string& query : queries) {
+            const auto start = chrono::steady_clock::now();
+            const CoordinatedResult result = coordinator.FindTopDocuments(query);
+            latencies.push_back(chrono::steady_clock::now() - start);
+            const auto expected = search_server.FindTopDocuments(query);
+            identical_count += equal(expected.begin(), expected.end(), result.documents.begin(), result.documents.end(), [](const Document& lhs, const Document& rhs) {
+                return lhs.id == rhs.id && lhs.relevance == rhs.relevance;
+                }) ? 1 : 0;
+            partial_count += result.IsComplete() ? 0 : 1;
+            hedged_request_count += result.hedged_request_count;
+        }
+        sort(latencies.begin(), latencies.end());
+        cout << "coordinator "s << name << ": "s << identical_count << " of "s << queries.size() << " identical, "s << partial_count << " partial, "s
+            << hedged_request_count << " hedged requests, p50 "s << chrono::duration_cast<chrono::microseconds>(latencies[latencies.size() / 2]).count()
+            << " us, p99 "s << chrono::duration_cast<chrono::microseconds>(latencies[latencies.size() * 99 / 100]).count() << " us"s << endl;
+    }
+
+    for (const pid_t pid : server_pids) {
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+    }
+    filesystem::remove_all(directory);
+}
+
+// Requests sent at once on one connection are answered in order: the document the first adds
+// is found by the second and gone for the fourth.
+void TestSearchDaemonRequests(const string& socket_path, const string& document) {
+    const int fd = ConnectUnixSocket(socket_path);
+    const string query = "QUERY daemonword\n"s;
+    SendAll(fd, "ADD 100000 5,5 daemonword "s + document + "\n"s + query + "REMOVE 100000\n"s + query + "QUERY --bad\nPING\n"s);
+    string responses;
+    char buffer[4096];
+    while (count(responses.begin(), responses.end(), '\n') < 6) {
+        const ssize_t size = read(fd, buffer, sizeof(buffer));
+        if (size <= 0) {
+            break;
+        }
+        responses.append(buffer, size);
+    }
+    close(fd);
+    for (size_t line_begin = 0, line_end; (line_end = responses.find('\n', line_begin)) != string::npos; line_begin = line_end + 1) {
+        const string line = responses.substr(line_begin, line_end - line_begin);
+        cout << "daemon response: "s << line.substr(0, 60) << (line.size() > 60 ? "..."s : ""s) << endl;
+    }
+}
+
+// The daemon runs on a thread of its own; batch size is how many queries it found waiting
+// per round, which grows with the connections and the pipeline depth.
+void TestSearchDaemon(const vector<string>& dictionary, const vector<string>& documents, const vector<string>& queries) {
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+    const string socket_path = (filesystem::temp_directory_path() / "search_daemon.sock"s).string();
+    SearchDaemon daemon(search_server, socket_path);
+    thread daemon_thread([&daemon] {
+        daemon.Run();
+        });
+
+    TestSearchDaemonRequests(socket_path, documents[0]);
+    const LoadClientResult check = RunLoadClient(socket_path, queries, { 1, 100, queries.size() });
+    cout << "daemon: "s << check.total_relevance << " over "s << check.request_count << " queries, "s << check.error_count << " errors"s << endl;
+    for (const auto& [connection_count, pipeline_depth] : { pair<size_t, size_t>{ 1, 1 }, pair<size_t, size_t>{ 1, 16 }, pair<size_t, size_t>{ 8, 16 } }) {
+        const SearchDaemonStats stats_before = daemon.GetStats();
+        const LoadClientResult result = RunLoadClient(socket_path, queries, { connection_count, pipeline_depth, 4000 });
+        const SearchDaemonStats stats = daemon.GetStats();
+        cout << "daemon "s << connection_count << " connections x "s << pipeline_depth << " in flight: "s << static_cast<int>(result.GetThroughput())
+            << " queries/s, p50 "s << chrono::duration_cast<chrono::microseconds>(result.GetLatencyPercentile(50)).count() << " us, p99 "s
+            << chrono::duration_cast<chrono::microseconds>(result.GetLatencyPercentile(99)).count() << " us, batches of "s
+            << (stats.query_count - stats_before.query_count) * 1.0 / (stats.batch_count - stats_before.batch_count) << " queries"s << endl;
+    }
+    daemon.Stop();
+    daemon_thread.join();
+}
+
+SearchDaemon* running_daemon = nullptr;
+
+void StopRunningDaemon(int) {
+    running_daemon->Stop();
+}
+
+// With no arguments, runs the demos above. Otherwise, on the same generated documents and queries:
+//   --daemon <socket path>                                      serves them until SIGINT or SIGTERM;
+//   --load <socket path> [connections] [pipeline depth] [requests]  loads a running daemon.
+int main(int argc, char* argv[]) {
     mt19937 generator;
 
     const auto dictionary = GenerateDictionary(generator, 1000, 10);
@@ -80,6 +954,64 @@ int main() {
 
     const auto queries = GenerateQueries(generator, dictionary, 100, 70);
 
+    if (argc >= 3 && argv[1] == "--daemon"s) {
+        SearchDaemon daemon(search_server, argv[2]);
+        running_daemon = &daemon;
+        signal(SIGINT, StopRunningDaemon);
+        signal(SIGTERM, StopRunningDaemon);
+        daemon.Run();
+        const SearchDaemonStats stats = daemon.GetStats();
+        cout << stats.connection_count << " connections, "s << stats.request_count << " requests, "s << stats.batch_count << " query batches"s << endl;
+        return 0;
+    }
+    if (argc >= 3 && argv[1] == "--load"s) {
+        LoadClientOptions options;
+        options.connection_count = argc > 3 ? stoul(argv[3]) : options.connection_count;
+        options.pipeline_depth = argc > 4 ? stoul(argv[4]) : options.pipeline_depth;
+        options.request_count = argc > 5 ? stoul(argv[5]) : options.request_count;
+        const LoadClientResult result = RunLoadClient(argv[2], queries, options);
+        cout << result.request_count << " requests, "s << result.error_count << " errors, "s << static_cast<int>(result.GetThroughput()) << " queries/s, p50 "s
+            << chrono::duration_cast<chrono::microseconds>(result.GetLatencyPercentile(50)).count() << " us, p99 "s
+            << chrono::duration_cast<chrono::microseconds>(result.GetLatencyPercentile(99)).count() << " us"s << endl;
+        return 0;
+    }
+
     TEST(seq);
     TEST(par);
+    TEST_SCORER(Bm25Scorer, seq);
+    TEST_SCORER(Bm25Scorer, par);
+    TestCount("count seq"s, search_server, queries, execution::seq);
+    TestCount("count par"s, search_server, queries, execution::par);
+    ThreadPool pool;
+    Test("pool"s, search_server, queries, pool);
+    TestCount("count pool"s, search_server, queries, pool);
+    TestProcessQueries("ProcessQueries"s, search_server, queries, [](const SearchServer& search_server, const vector<string>& queries) {
+        return ProcessQueries(search_server, queries);
+        });
+    TestProcessQueries("ProcessQueries pool"s, search_server, queries, [&pool](const SearchServer& search_server, const vector<string>& queries) {
+        return ProcessQueries(pool, search_server, queries);
+        });
+    TestProcessQueries("ProcessQueriesBatched"s, search_server, queries, ProcessQueriesBatched);
+    CompareBatchOnOverlappingQueries(search_server, dictionary);
+    TestJoinedResults(search_server, queries);
+    CountQueryAllocations(search_server, queries);
+
+    BenchmarkScoringKernels(generator);
+    CompareTermFreqStorage(dictionary, documents, queries);
+    CompareIndexHugePages(dictionary, documents, queries);
+    TestAddRemoveCycles(dictionary, documents, queries);
+    TestConcurrentUpdates(dictionary, documents, queries);
+    CompareSegmentedIndex(dictionary, documents, queries);
+    CompareBulkIngest(dictionary, documents, queries, pool);
+    TestIngestPipeline(dictionary, documents, queries);
+    TestConcurrentWriters(dictionary, documents, queries);
+    CompareMappedIndex(search_server, queries);
+    CompareWalSyncPolicies(dictionary, documents, queries);
+    MeasureCheckpointLatency(dictionary, documents, queries);
+    TestReplicaProcesses(dictionary, documents, queries);
+    TestLogShipping(dictionary, documents, queries);
+    TestSlowFollower(documents);
+    CompareShardedIndex(dictionary, documents, queries);
+    TestShardCoordinator(search_server, dictionary, documents, queries);
+    TestSearchDaemon(dictionary, documents, queries);
 }
\ No newline at end of file
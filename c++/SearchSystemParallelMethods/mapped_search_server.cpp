@@ -0,0 +1,256 @@
+#include "mapped_search_server.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <new>
+#endif
+
+MappedSearchServer::MappedSearchServer(const std::string& path) {
+#ifdef __linux__
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open index file "s + path);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot open index file "s + path);
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    void* mapping = size_ == 0 ? MAP_FAILED : mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map index file "s + path);
+    }
+    data_ = static_cast<const std::byte*>(mapping);
+#else
+    // Without mmap the file is read into one aligned block, which gives up the constant open time.
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        throw std::runtime_error("Cannot open index file "s + path);
+    }
+    size_ = static_cast<size_t>(in.tellg());
+    std::byte* buffer = static_cast<std::byte*>(::operator new(size_, std::align_val_t(INDEX_SECTION_ALIGNMENT)));
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(buffer), size_);
+    data_ = buffer;
+#endif
+
+    try {
+        header_ = reinterpret_cast<const IndexFileHeader*>(data_);
+        if (size_ < sizeof(IndexFileHeader) || std::memcmp(header_->magic, INDEX_FILE_MAGIC, sizeof(INDEX_FILE_MAGIC)) != 0) {
+            throw std::runtime_error(path + " is not an index file"s);
+        }
+        if (header_->version != INDEX_FILE_VERSION || header_->byte_order != INDEX_BYTE_ORDER_MARK
+            || header_->term_freq_storage > static_cast<uint32_t>(TermFreqStorage::COUNT)) {
+            throw std::runtime_error("Unsupported index file version or byte order in "s + path);
+        }
+        term_freq_storage_ = static_cast<TermFreqStorage>(header_->term_freq_storage);
+
+        const uint64_t term_count = header_->term_count;
+        const uint64_t posting_count = header_->posting_count;
+        const uint64_t slot_count = header_->slot_count;
+        const uint64_t* stop_word_offsets = GetSection<uint64_t>(IndexSection::STOP_WORD_OFFSETS, header_->stop_word_count + 1);
+        const char* stop_word_chars = GetSection<char>(IndexSection::STOP_WORD_CHARS, stop_word_offsets[header_->stop_word_count]);
+        for (uint64_t i = 0; i < header_->stop_word_count; ++i) {
+            stop_words_.emplace(stop_word_chars + stop_word_offsets[i], stop_word_offsets[i + 1] - stop_word_offsets[i]);
+        }
+        term_offsets_ = GetSection<uint64_t>(IndexSection::TERM_OFFSETS, term_count + 1);
+        term_chars_ = GetSection<char>(IndexSection::TERM_CHARS, term_offsets_[term_count]);
+        posting_offsets_ = GetSection<uint64_t>(IndexSection::POSTING_OFFSETS, term_count + 1);
+        posting_slots_ = GetSection<uint32_t>(IndexSection::POSTING_SLOTS, posting_count);
+        switch (term_freq_storage_) {
+        case TermFreqStorage::DOUBLE:
+            term_freqs_ = GetSection<double>(IndexSection::POSTING_TERM_FREQS, posting_count);
+            break;
+        case TermFreqStorage::FLOAT:
+            float_term_freqs_ = GetSection<float>(IndexSection::POSTING_TERM_FREQS, posting_count);
+            break;
+        case TermFreqStorage::COUNT:
+            word_counts_ = GetSection<uint16_t>(IndexSection::POSTING_TERM_FREQS, posting_count);
+            break;
+        }
+        document_ids_ = GetSection<int>(IndexSection::DOCUMENT_IDS, slot_count);
+        document_ratings_ = GetSection<int>(IndexSection::DOCUMENT_RATINGS, slot_count);
+        document_statuses_ = GetSection<DocumentStatus>(IndexSection::DOCUMENT_STATUSES, slot_count);
+        document_word_counts_ = GetSection<int>(IndexSection::DOCUMENT_WORD_COUNTS, slot_count);
+        document_inv_word_counts_ = GetSection<double>(IndexSection::DOCUMENT_INV_WORD_COUNTS, slot_count);
+        forward_offsets_ = GetSection<uint64_t>(IndexSection::FORWARD_OFFSETS, slot_count + 1);
+        forward_terms_ = GetSection<uint32_t>(IndexSection::FORWARD_TERMS, header_->forward_term_count);
+        sorted_ids_ = GetSection<int>(IndexSection::SORTED_IDS, slot_count);
+        sorted_id_slots_ = GetSection<uint32_t>(IndexSection::SORTED_ID_SLOTS, slot_count);
+    }
+    catch (...) {
+        Unmap(data_, size_);
+        throw;
+    }
+}
+
+MappedSearchServer::MappedSearchServer(MappedSearchServer&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr))
+    , size_(std::exchange(other.size_, 0))
+    , header_(other.header_)
+    , term_freq_storage_(other.term_freq_storage_)
+    , stop_words_(std::move(other.stop_words_))
+    , term_offsets_(other.term_offsets_)
+    , term_chars_(other.term_chars_)
+    , posting_offsets_(other.posting_offsets_)
+    , posting_slots_(other.posting_slots_)
+    , term_freqs_(other.term_freqs_)
+    , float_term_freqs_(other.float_term_freqs_)
+    , word_counts_(other.word_counts_)
+    , document_ids_(other.document_ids_)
+    , document_ratings_(other.document_ratings_)
+    , document_statuses_(other.document_statuses_)
+    , document_word_counts_(other.document_word_counts_)
+    , document_inv_word_counts_(other.document_inv_word_counts_)
+    , forward_offsets_(other.forward_offsets_)
+    , forward_terms_(other.forward_terms_)
+    , sorted_ids_(other.sorted_ids_)
+    , sorted_id_slots_(other.sorted_id_slots_) {
+}
+
+MappedSearchServer::~MappedSearchServer() {
+    if (data_ != nullptr) {
+        Unmap(data_, size_);
+    }
+}
+
+std::vector<Document> MappedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(std::execution::seq, raw_query, status);
+}
+
+std::vector<Document> MappedSearchServer::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(std::execution::seq, raw_query);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> MappedSearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
+    const uint32_t* slot = FindSlot(document_id);
+    if (slot == nullptr) {
+        throw std::out_of_range("can't find document id at server");
+    }
+
+    ScratchLease scratch;
+    const auto query = SearchServer::ParseQuery(raw_query, stop_words_, scratch->tokens, std::pmr::get_default_resource());
+    const uint32_t* document_terms_begin = forward_terms_ + forward_offsets_[*slot];
+    const uint32_t* document_terms_end = forward_terms_ + forward_offsets_[*slot + 1];
+    const DocumentStatus status = document_statuses_[*slot];
+    const auto find_term = [&](std::string_view word) -> const uint32_t* {
+        const auto term_it = std::lower_bound(document_terms_begin, document_terms_end, word, [this](uint32_t term, std::string_view word) {
+            return GetTerm(term) < word;
+            });
+        return term_it != document_terms_end && GetTerm(*term_it) == word ? term_it : nullptr;
+    };
+
+    const bool has_minus_word = std::any_of(query.minus_words.begin(), query.minus_words.end(), [&find_term](const auto& word) {
+        return find_term(word) != nullptr;
+        });
+    if (has_minus_word) {
+        return { std::vector<std::string_view>{}, status };
+    }
+
+    std::vector<std::string_view> matched_words;
+    for (const auto& word : query.plus_words) {
+        if (const uint32_t* term = find_term(word)) {
+            matched_words.push_back(GetTerm(*term));
+        }
+    }
+    return { matched_words, status };
+}
+
+int MappedSearchServer::GetDocumentCount() const {
+    return static_cast<int>(header_->slot_count);
+}
+
+bool MappedSearchServer::ContainsDocument(int document_id) const {
+    return FindSlot(document_id) != nullptr;
+}
+
+CorpusStats MappedSearchServer::GetCorpusStats() const {
+    const int document_count = GetDocumentCount();
+    return { document_count, document_count == 0 ? 0.0 : header_->total_word_count * 1.0 / document_count };
+}
+
+TermFreqStorage MappedSearchServer::GetTermFreqStorage() const {
+    return term_freq_storage_;
+}
+
+size_t MappedSearchServer::GetFileSize() const {
+    return size_;
+}
+
+void MappedSearchServer::Unmap(const std::byte* data, size_t size) {
+#ifdef __linux__
+    munmap(const_cast<std::byte*>(data), size);
+#else
+    ::operator delete(const_cast<std::byte*>(data), std::align_val_t(INDEX_SECTION_ALIGNMENT));
+#endif
+}
+
+// Checks bounds and alignment only: the contents are trusted, reading them all would make opening linear.
+template <typename T>
+const T* MappedSearchServer::GetSection(IndexSection section, uint64_t count) const {
+    const IndexFileSection& file_section = header_->sections[static_cast<size_t>(section)];
+    if (file_section.offset % INDEX_SECTION_ALIGNMENT != 0 || file_section.size != count * sizeof(T)
+        || file_section.offset > size_ || file_section.size > size_ - file_section.offset) {
+        throw std::runtime_error("Index file is truncated or corrupt"s);
+    }
+    return reinterpret_cast<const T*>(data_ + file_section.offset);
+}
+
+std::string_view MappedSearchServer::GetTerm(uint32_t term) const {
+    return { term_chars_ + term_offsets_[term], term_offsets_[term + 1] - term_offsets_[term] };
+}
+
+SearchServer::PostingView MappedSearchServer::FindPostings(std::string_view word) const {
+    uint32_t low = 0;
+    uint32_t high = static_cast<uint32_t>(header_->term_count);
+    while (low < high) {
+        const uint32_t middle = low + (high - low) / 2;
+        if (GetTerm(middle) < word) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    if (low == header_->term_count || GetTerm(low) != word) {
+        return {};
+    }
+    const size_t begin = posting_offsets_[low];
+    SearchServer::PostingView postings;
+    postings.slots = posting_slots_ + begin;
+    postings.size = posting_offsets_[low + 1] - begin;
+    switch (term_freq_storage_) {
+    case TermFreqStorage::DOUBLE:
+        postings.term_freqs = term_freqs_ + begin;
+        break;
+    case TermFreqStorage::FLOAT:
+        postings.float_term_freqs = float_term_freqs_ + begin;
+        break;
+    case TermFreqStorage::COUNT:
+        postings.word_counts = word_counts_ + begin;
+        break;
+    }
+    return postings;
+}
+
+const uint32_t* MappedSearchServer::FindSlot(int document_id) const {
+    const int* sorted_ids_end = sorted_ids_ + header_->slot_count;
+    const int* id_it = std::lower_bound(sorted_ids_, sorted_ids_end, document_id);
+    return id_it != sorted_ids_end && *id_it == document_id ? sorted_id_slots_ + (id_it - sorted_ids_) : nullptr;
+}
+
+SearchServer::IndexView MappedSearchServer::GetIndexView() const {
+    return { term_freq_storage_, header_->slot_count, document_ids_, document_ratings_, document_statuses_, document_word_counts_,
+        document_inv_word_counts_ };
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "index_format.h"
+#include "search_server.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+// Read-only search server over a file written by SearchServer::Save. The file is mapped and
+// its arrays are used in place: opening checks the header and reads the stop words, nothing
+// else, so it takes the same time for any corpus, and the pages of postings and columns are
+// faulted in as queries touch them. Servers mapping the same file, in one process or several,
+// share its page cache. Queries return the same documents as the SearchServer that was saved.
+class MappedSearchServer {
+public:
+    explicit MappedSearchServer(const std::string& path);
+    MappedSearchServer(MappedSearchServer&& other) noexcept;
+    MappedSearchServer& operator=(MappedSearchServer&&) = delete;
+    ~MappedSearchServer();
+
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, const PageRequest& page) const;
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status, const PageRequest& page) const;
+
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const;
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+
+    int GetDocumentCount() const;
+    bool ContainsDocument(int document_id) const;
+    CorpusStats GetCorpusStats() const;
+    TermFreqStorage GetTermFreqStorage() const;
+    size_t GetFileSize() const;
+
+private:
+    friend class SearchServer;
+
+    static_assert(sizeof(int) == sizeof(int32_t) && sizeof(DocumentStatus) == sizeof(int32_t));
+
+    static void Unmap(const std::byte* data, size_t size);
+    template <typename T>
+    const T* GetSection(IndexSection section, uint64_t count) const;
+
+    std::string_view GetTerm(uint32_t term) const;
+    // Saved terms have at least one posting; a word that is not in the file gets an empty view.
+    SearchServer::PostingView FindPostings(std::string_view word) const;
+    const uint32_t* FindSlot(int document_id) const;
+    SearchServer::IndexView GetIndexView() const;
+
+    const std::byte* data_ = nullptr;
+    size_t size_ = 0;
+    const IndexFileHeader* header_ = nullptr;
+    TermFreqStorage term_freq_storage_ = TermFreqStorage::DOUBLE;
+    std::set<std::string, std::less<>> stop_words_;
+
+    const uint64_t* term_offsets_ = nullptr;
+    const char* term_chars_ = nullptr;
+    const uint64_t* posting_offsets_ = nullptr;
+    const uint32_t* posting_slots_ = nullptr;
+    const double* term_freqs_ = nullptr;
+    const float* float_term_freqs_ = nullptr;
+    const uint16_t* word_counts_ = nullptr;
+    const int* document_ids_ = nullptr;
+    const int* document_ratings_ = nullptr;
+    const DocumentStatus* document_statuses_ = nullptr;
+    const int* document_word_counts_ = nullptr;
+    const double* document_inv_word_counts_ = nullptr;
+    const uint64_t* forward_offsets_ = nullptr;
+    const uint32_t* forward_terms_ = nullptr;
+    const int* sorted_ids_ = nullptr;
+    const uint32_t* sorted_id_slots_ = nullptr;
+};
+
+
+// The query path is SearchServer's, run over the mapped arrays.
+template <typename Scorer, typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> MappedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, const PageRequest& page) const {
+    return SearchServer::FindPage<Scorer>(policy, GetIndexView(), [this](std::string_view word) {
+        return FindPostings(word);
+        }, stop_words_, raw_query, document_predicate, page, GetCorpusStats(), nullptr);
+}
+
+template <typename Scorer, typename ExecutionPolicy>
+std::vector<Document> MappedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status, const PageRequest& page) const {
+    return FindTopDocuments<Scorer>(policy, raw_query, DocumentStatusPredicate{ status }, page);
+}
+
+template <typename Scorer, typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> MappedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return FindTopDocuments<Scorer>(policy, raw_query, document_predicate, PageRequest{});
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> MappedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+}
+
+template <typename Scorer, typename ExecutionPolicy>
+std::vector<Document> MappedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments<Scorer>(policy, raw_query, DocumentStatusPredicate{ status });
+}
+
+template <typename Scorer, typename ExecutionPolicy>
+std::vector<Document> MappedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const {
+    return FindTopDocuments<Scorer>(policy, raw_query, DocumentStatus::ACTUAL);
+}
\ No newline at end of file
@@ -12,6 +12,25 @@ std::vector<std::vector<Document>> ProcessQueries(
     return result;
 }
 
+std::vector<std::vector<Document>> ProcessQueries(
+    ThreadPool& pool,
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries)
+{
+    std::vector<std::vector<Document>> result(queries.size());
+    Transform(pool, queries.begin(), queries.end(), result.begin(), [&search_server](const std::string& query) {
+        return search_server.FindTopDocuments(query);
+        });
+    return result;
+}
+
+std::vector<std::vector<Document>> ProcessQueriesBatched(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries)
+{
+    return search_server.FindTopDocumentsBatch(std::execution::par, queries);
+}
+
 std::list<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
     const std::vector<std::string>& queries) {
@@ -20,4 +39,42 @@ std::list<Document> ProcessQueriesJoined(
         result.splice(result.end(), std::move(std::list<Document>(std::make_move_iterator(vector_to_docs.begin()), std::make_move_iterator(vector_to_docs.end()))));
     }
     return result;
+}
+
+size_t JoinedResults::GetQueryCount() const {
+    return query_offsets.size() - 1;
+}
+
+IteratorRange<std::vector<Document>::const_iterator> JoinedResults::GetQueryResults(size_t query_index) const {
+    return { documents.begin() + query_offsets.at(query_index), documents.begin() + query_offsets.at(query_index + 1) };
+}
+
+JoinedResults ProcessQueriesFlat(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries)
+{
+    // Query i writes into its own stride of MAX_RESULT_DOCUMENT_COUNT documents; the gaps left by
+    // shorter results are closed afterwards, front to back.
+    const size_t query_count = queries.size();
+    JoinedResults result;
+    result.documents.resize(query_count * MAX_RESULT_DOCUMENT_COUNT);
+    std::vector<size_t> query_sizes(query_count);
+    std::vector<size_t> query_indices(query_count);
+    std::iota(query_indices.begin(), query_indices.end(), 0);
+    std::for_each(std::execution::par, query_indices.begin(), query_indices.end(), [&](size_t i) {
+        const std::vector<Document> documents = search_server.FindTopDocuments(queries[i]);
+        std::copy(documents.begin(), documents.end(), result.documents.begin() + i * MAX_RESULT_DOCUMENT_COUNT);
+        query_sizes[i] = documents.size();
+        });
+
+    result.query_offsets.resize(query_count + 1);
+    for (size_t i = 0; i < query_count; ++i) {
+        const auto stride_begin = result.documents.begin() + i * MAX_RESULT_DOCUMENT_COUNT;
+        if (result.query_offsets[i] != i * MAX_RESULT_DOCUMENT_COUNT) {
+            std::copy(stride_begin, stride_begin + query_sizes[i], result.documents.begin() + result.query_offsets[i]);
+        }
+        result.query_offsets[i + 1] = result.query_offsets[i] + query_sizes[i];
+    }
+    result.documents.resize(result.query_offsets.back());
+    return result;
 }
\ No newline at end of file
@@ -1,13 +1,58 @@
 #pragma once
 
+#include "paginator.h"
 #include "search_server.h"
 
 #include <list>
+#include <mutex>
 
 std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
 
+// Same as ProcessQueries, scheduled on the given pool instead of the standard library's executor.
+std::vector<std::vector<Document>> ProcessQueries(
+    ThreadPool& pool,
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries);
+
+// Same results as ProcessQueries, computed by SearchServer::FindTopDocumentsBatch so that
+// queries sharing words share posting decoding and scoring.
+std::vector<std::vector<Document>> ProcessQueriesBatched(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries);
+
 std::list<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
-    const std::vector<std::string>& queries);
\ No newline at end of file
+    const std::vector<std::string>& queries);
+
+// Results of a whole batch in one buffer: query i owns documents[query_offsets[i], query_offsets[i + 1]).
+struct JoinedResults {
+    std::vector<Document> documents;
+    std::vector<size_t> query_offsets = { 0 };
+
+    size_t GetQueryCount() const;
+    IteratorRange<std::vector<Document>::const_iterator> GetQueryResults(size_t query_index) const;
+};
+
+JoinedResults ProcessQueriesFlat(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries);
+
+// Calls sink(query_index, documents) for every query as soon as it is answered, in completion
+// order rather than query order. Calls are serialized, so the sink needs no locking of its own.
+template <typename ResultSink>
+void ProcessQueriesStreamed(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries,
+    ResultSink sink)
+{
+    std::vector<size_t> query_indices(queries.size());
+    std::iota(query_indices.begin(), query_indices.end(), 0);
+    std::mutex sink_mutex;
+    std::for_each(std::execution::par, query_indices.begin(), query_indices.end(), [&](size_t query_index) {
+        const std::vector<Document> documents = search_server.FindTopDocuments(queries[query_index]);
+        std::lock_guard guard(sink_mutex);
+        sink(query_index, documents);
+        });
+}
\ No newline at end of file
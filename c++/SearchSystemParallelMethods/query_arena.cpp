@@ -0,0 +1,42 @@
+#include "query_arena.h"
+
+#include <algorithm>
+
+QueryArena::QueryArena(size_t initial_bytes) : buffer_(initial_bytes) {
+    resource_.emplace(buffer_.data(), buffer_.size(), &upstream_);
+}
+
+std::pmr::memory_resource* QueryArena::GetResource() {
+    return &*resource_;
+}
+
+void QueryArena::Reset() {
+    resource_->release();
+    if (upstream_.allocated_bytes > overflow_bytes_) {
+        buffer_.resize(std::max(2 * buffer_.size(), buffer_.size() + upstream_.allocated_bytes - overflow_bytes_));
+        resource_.emplace(buffer_.data(), buffer_.size(), &upstream_);
+    }
+    overflow_bytes_ = upstream_.allocated_bytes;
+}
+
+size_t QueryArena::GetCapacity() const {
+    return buffer_.size();
+}
+
+size_t QueryArena::GetUpstreamAllocationCount() const {
+    return upstream_.allocation_count;
+}
+
+void* QueryArena::UpstreamResource::do_allocate(size_t bytes, size_t alignment) {
+    ++allocation_count;
+    allocated_bytes += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void QueryArena::UpstreamResource::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+}
+
+bool QueryArena::UpstreamResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+// Monotonic arena for everything a single query allocates. Reset() drops it all at once; when
+// a query outgrew the buffer, the buffer is enlarged so later queries stay off the heap.
+class QueryArena {
+public:
+    explicit QueryArena(size_t initial_bytes = INITIAL_BYTES);
+    QueryArena(const QueryArena&) = delete;
+    QueryArena& operator=(const QueryArena&) = delete;
+
+    std::pmr::memory_resource* GetResource();
+    void Reset();
+
+    size_t GetCapacity() const;
+    // Heap allocations the arena made on behalf of queries since it was created.
+    size_t GetUpstreamAllocationCount() const;
+
+private:
+    static constexpr size_t INITIAL_BYTES = 16 * 1024;
+
+    class UpstreamResource : public std::pmr::memory_resource {
+    public:
+        size_t allocation_count = 0;
+        size_t allocated_bytes = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    };
+
+    std::vector<std::byte> buffer_;
+    UpstreamResource upstream_;
+    size_t overflow_bytes_ = 0;
+    std::optional<std::pmr::monotonic_buffer_resource> resource_;
+};
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+struct CorpusStats {
+    int document_count = 0;
+    double average_document_length = 0.0;
+};
+
+// Statistics of a corpus split over several indexes, summed up so that each index scores a
+// query as if it held the whole corpus. document_freqs has an entry for every plus word of the query.
+struct TermStats {
+    int document_count = 0;
+    int64_t total_word_count = 0;
+    std::map<std::string, int, std::less<>> document_freqs;
+
+    CorpusStats GetCorpusStats() const {
+        return { document_count, document_count == 0 ? 0.0 : total_word_count * 1.0 / document_count };
+    }
+};
+
+// Scorers are passed to FindTopDocuments as a template argument, so
+// ComputeScore is inlined straight into the posting loop.
+class TfIdfScorer {
+public:
+    // Score is term_freq * weight, so FindAllDocuments can hand whole posting blocks to the SIMD kernel.
+    static constexpr bool LINEAR_IN_TERM_FREQ = true;
+
+    explicit TfIdfScorer(const CorpusStats& corpus_stats) : document_count_(corpus_stats.document_count) {
+    }
+
+    double ComputeWordWeight(int document_freq) const {
+        return std::log(document_count_ * 1.0 / document_freq);
+    }
+
+    double ComputeScore(double word_weight, double term_freq, int /*document_length*/) const {
+        return term_freq * word_weight;
+    }
+
+private:
+    int document_count_;
+};
+
+// Okapi BM25. Document lengths are stored at ingest; the average length is
+// folded into two per-query constants so the norm is one multiply-add per posting.
+class Bm25Scorer {
+public:
+    static constexpr bool LINEAR_IN_TERM_FREQ = false;
+    static constexpr double K1 = 1.2;
+    static constexpr double B = 0.75;
+
+    explicit Bm25Scorer(const CorpusStats& corpus_stats)
+        : document_count_(corpus_stats.document_count)
+        , norm_base_(K1 * (1.0 - B))
+        , norm_per_word_(corpus_stats.average_document_length > 0.0 ? K1 * B / corpus_stats.average_document_length : 0.0) {
+    }
+
+    double ComputeWordWeight(int document_freq) const {
+        return std::log(1.0 + (document_count_ - document_freq + 0.5) / (document_freq + 0.5));
+    }
+
+    double ComputeScore(double word_weight, double term_freq, int document_length) const {
+        const double word_count = term_freq * document_length;
+        const double length_norm = norm_base_ + norm_per_word_ * document_length;
+        return word_weight * word_count * (K1 + 1.0) / (word_count + length_norm);
+    }
+
+private:
+    int document_count_;
+    double norm_base_;
+    double norm_per_word_;
+};
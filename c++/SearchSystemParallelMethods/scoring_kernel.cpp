@@ -0,0 +1,194 @@
+#include "scoring_kernel.h"
+
+#include <cmath>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SCORING_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std::literals;
+
+namespace {
+
+static_assert(sizeof(DocumentStatus) == sizeof(int32_t) && sizeof(int) == sizeof(int32_t), "mask kernels compare 32-bit statuses and ratings");
+
+bool IsMatched(double score) {
+    return !std::signbit(score);
+}
+
+void AccumulateScoresScalar(const uint32_t* slots, const double* term_freqs, size_t count, double word_weight, double* scores) {
+    for (size_t i = 0; i < count; ++i) {
+        scores[slots[i]] += term_freqs[i] * word_weight;
+    }
+}
+
+void SelectMatchedSlotsScalar(const double* scores, size_t begin, size_t count, std::vector<uint32_t>& matched_slots) {
+    for (size_t slot = begin; slot < count; ++slot) {
+        if (IsMatched(scores[slot])) {
+            matched_slots.push_back(static_cast<uint32_t>(slot));
+        }
+    }
+}
+
+void SelectMatchedSlotsScalar(const double* scores, const DocumentStatus* statuses, const int* ratings, size_t begin, size_t count, DocumentStatus status,
+    int min_rating, std::vector<uint32_t>& matched_slots) {
+    for (size_t slot = begin; slot < count; ++slot) {
+        if (IsMatched(scores[slot]) && statuses[slot] == status && ratings[slot] >= min_rating) {
+            matched_slots.push_back(static_cast<uint32_t>(slot));
+        }
+    }
+}
+
+#ifdef SCORING_KERNEL_X86
+
+void AppendMaskedSlots(unsigned mask, size_t base, std::vector<uint32_t>& matched_slots) {
+    while (mask != 0) {
+        const int lane = __builtin_ctz(mask);
+        matched_slots.push_back(static_cast<uint32_t>(base + lane));
+        mask &= mask - 1;
+    }
+}
+
+// AVX2 has gathers but no scatters, so the sums are written back lane by lane. The masked
+// gathers load every lane; they only avoid the unmasked ones' undefined source register.
+__attribute__((target("avx2")))
+void AccumulateScoresAvx2(const uint32_t* slots, const double* term_freqs, size_t count, double word_weight, double* scores) {
+    const __m256d weight = _mm256_set1_pd(word_weight);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i index = _mm_loadu_si128(reinterpret_cast<const __m128i*>(slots + i));
+        const __m256d contribution = _mm256_mul_pd(_mm256_loadu_pd(term_freqs + i), weight);
+        const __m256d sum = _mm256_add_pd(_mm256_mask_i32gather_pd(_mm256_setzero_pd(), scores, index, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8), contribution);
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, sum);
+        scores[slots[i]] = lanes[0];
+        scores[slots[i + 1]] = lanes[1];
+        scores[slots[i + 2]] = lanes[2];
+        scores[slots[i + 3]] = lanes[3];
+    }
+    AccumulateScoresScalar(slots + i, term_freqs + i, count - i, word_weight, scores);
+}
+
+__attribute__((target("avx512f")))
+void AccumulateScoresAvx512(const uint32_t* slots, const double* term_freqs, size_t count, double word_weight, double* scores) {
+    const __m512d weight = _mm512_set1_pd(word_weight);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(slots + i));
+        const __m512d contribution = _mm512_mul_pd(_mm512_loadu_pd(term_freqs + i), weight);
+        const __m512d sum = _mm512_add_pd(_mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, index, scores, 8), contribution);
+        _mm512_i32scatter_pd(scores, index, sum, 8);
+    }
+    AccumulateScoresScalar(slots + i, term_freqs + i, count - i, word_weight, scores);
+}
+
+__attribute__((target("avx2")))
+void SelectMatchedSlotsAvx2(const double* scores, size_t count, std::vector<uint32_t>& matched_slots) {
+    size_t slot = 0;
+    for (; slot + 4 <= count; slot += 4) {
+        const unsigned unmatched = _mm256_movemask_pd(_mm256_loadu_pd(scores + slot));
+        AppendMaskedSlots(~unmatched & 0xFu, slot, matched_slots);
+    }
+    SelectMatchedSlotsScalar(scores, slot, count, matched_slots);
+}
+
+__attribute__((target("avx2")))
+void SelectMatchedSlotsAvx2(const double* scores, const DocumentStatus* statuses, const int* ratings, size_t count, DocumentStatus status, int min_rating,
+    std::vector<uint32_t>& matched_slots) {
+    const __m128i wanted = _mm_set1_epi32(static_cast<int32_t>(status));
+    const __m128i lowest_rating = _mm_set1_epi32(min_rating);
+    size_t slot = 0;
+    for (; slot + 4 <= count; slot += 4) {
+        const unsigned unmatched = _mm256_movemask_pd(_mm256_loadu_pd(scores + slot));
+        const __m128i lane_statuses = _mm_loadu_si128(reinterpret_cast<const __m128i*>(statuses + slot));
+        const unsigned same_status = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(lane_statuses, wanted)));
+        const __m128i lane_ratings = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ratings + slot));
+        const unsigned low_rating = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(lowest_rating, lane_ratings)));
+        AppendMaskedSlots(~unmatched & same_status & ~low_rating & 0xFu, slot, matched_slots);
+    }
+    SelectMatchedSlotsScalar(scores, statuses, ratings, slot, count, status, min_rating, matched_slots);
+}
+
+#endif
+
+using AccumulateFunction = void (*)(const uint32_t*, const double*, size_t, double, double*);
+
+AccumulateFunction GetAccumulateFunction(ScoringKernel kernel) {
+#ifdef SCORING_KERNEL_X86
+    switch (kernel) {
+    case ScoringKernel::AVX512:
+        return AccumulateScoresAvx512;
+    case ScoringKernel::AVX2:
+        return AccumulateScoresAvx2;
+    default:
+        break;
+    }
+#endif
+    return AccumulateScoresScalar;
+}
+
+ScoringKernel GetActiveKernel() {
+    static const ScoringKernel kernel = DetectScoringKernel();
+    return kernel;
+}
+
+} // namespace
+
+ScoringKernel DetectScoringKernel() {
+#ifdef SCORING_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return ScoringKernel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return ScoringKernel::AVX2;
+    }
+#endif
+    return ScoringKernel::SCALAR;
+}
+
+bool IsScoringKernelSupported(ScoringKernel kernel) {
+    return static_cast<int>(kernel) <= static_cast<int>(GetActiveKernel());
+}
+
+std::string_view GetScoringKernelName(ScoringKernel kernel) {
+    switch (kernel) {
+    case ScoringKernel::AVX512:
+        return "avx512"sv;
+    case ScoringKernel::AVX2:
+        return "avx2"sv;
+    default:
+        return "scalar"sv;
+    }
+}
+
+void AccumulateScores(const uint32_t* slots, const double* term_freqs, size_t count, double word_weight, double* scores) {
+    static const AccumulateFunction accumulate = GetAccumulateFunction(GetActiveKernel());
+    accumulate(slots, term_freqs, count, word_weight, scores);
+}
+
+void AccumulateScores(ScoringKernel kernel, const uint32_t* slots, const double* term_freqs, size_t count, double word_weight, double* scores) {
+    GetAccumulateFunction(kernel)(slots, term_freqs, count, word_weight, scores);
+}
+
+void SelectMatchedSlots(const double* scores, size_t count, std::vector<uint32_t>& matched_slots) {
+#ifdef SCORING_KERNEL_X86
+    if (GetActiveKernel() != ScoringKernel::SCALAR) {
+        SelectMatchedSlotsAvx2(scores, count, matched_slots);
+        return;
+    }
+#endif
+    SelectMatchedSlotsScalar(scores, 0, count, matched_slots);
+}
+
+void SelectMatchedSlots(const double* scores, const DocumentStatus* statuses, const int* ratings, size_t count, DocumentStatus status, int min_rating,
+    std::vector<uint32_t>& matched_slots) {
+#ifdef SCORING_KERNEL_X86
+    if (GetActiveKernel() != ScoringKernel::SCALAR) {
+        SelectMatchedSlotsAvx2(scores, statuses, ratings, count, status, min_rating, matched_slots);
+        return;
+    }
+#endif
+    SelectMatchedSlotsScalar(scores, statuses, ratings, 0, count, status, min_rating, matched_slots);
+}
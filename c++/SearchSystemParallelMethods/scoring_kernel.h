@@ -0,0 +1,33 @@
+#pragma once
+
+#include "document.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Dense accumulators start at -0.0, so "not matched" is just the sign bit:
+// adding any non-negative contribution clears it, even a zero one.
+constexpr double UNMATCHED_SCORE = -0.0;
+
+enum class ScoringKernel {
+    SCALAR,
+    AVX2,
+    AVX512,
+};
+
+ScoringKernel DetectScoringKernel();
+bool IsScoringKernelSupported(ScoringKernel kernel);
+std::string_view GetScoringKernelName(ScoringKernel kernel);
+
+// scores[slots[i]] += term_freqs[i] * word_weight. Slots must be unique within one call,
+// which holds for any block of a single posting list.
+void AccumulateScores(const uint32_t* slots, const double* term_freqs, size_t count, double word_weight, double* scores);
+void AccumulateScores(ScoringKernel kernel, const uint32_t* slots, const double* term_freqs, size_t count, double word_weight, double* scores);
+
+// Appends every slot in [0, count) that was matched (and has the given status and a rating of
+// at least min_rating) to matched_slots.
+void SelectMatchedSlots(const double* scores, size_t count, std::vector<uint32_t>& matched_slots);
+void SelectMatchedSlots(const double* scores, const DocumentStatus* statuses, const int* ratings, size_t count, DocumentStatus status, int min_rating,
+    std::vector<uint32_t>& matched_slots);
@@ -0,0 +1,323 @@
+#include "search_daemon.h"
+
+#include "unix_socket.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <execution>
+#include <stdexcept>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint64_t LISTEN_EVENT_ID = 0;
+constexpr uint64_t STOP_EVENT_ID = 1;
+constexpr size_t MAX_LINE_SIZE = 1u << 20;
+constexpr size_t RECEIVE_BUFFER_SIZE = 64 * 1024;
+constexpr int MAX_EVENT_COUNT = 256;
+
+epoll_event MakeEvent(uint32_t events, uint64_t event_id) {
+    epoll_event event{};
+    event.events = events;
+    event.data.u64 = event_id;
+    return event;
+}
+
+// Splits off the first space-separated word of text.
+std::string_view TakeWord(std::string_view& text) {
+    const size_t end = std::min(text.find(' '), text.size());
+    const std::string_view word = text.substr(0, end);
+    text.remove_prefix(std::min(end + 1, text.size()));
+    return word;
+}
+
+int ParseInt(std::string_view text) {
+    int value = 0;
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc() || end != text.data() + text.size()) {
+        throw std::invalid_argument("Invalid number: "s + std::string(text));
+    }
+    return value;
+}
+
+std::string FormatDocuments(const std::vector<Document>& documents) {
+    std::string response = "OK "s + std::to_string(documents.size());
+    char buffer[32];
+    for (const Document& document : documents) {
+        response += ' ';
+        response += std::to_string(document.id);
+        response += ' ';
+        response.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), document.relevance).ptr);
+        response += ' ';
+        response += std::to_string(document.rating);
+    }
+    return response;
+}
+
+} // namespace
+
+SearchDaemon::SearchDaemon(SearchServer& search_server, const std::string& socket_path, SearchDaemonOptions options)
+    : search_server_(search_server)
+    , socket_path_(socket_path)
+    , options_(options)
+    , listen_fd_(ListenUnixSocket(socket_path))
+    , epoll_fd_(epoll_create1(EPOLL_CLOEXEC))
+    , stop_fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {
+    if (options_.max_batch_size == 0) {
+        throw std::invalid_argument("Batches must take at least one query"s);
+    }
+    epoll_event listen_event = MakeEvent(EPOLLIN, LISTEN_EVENT_ID);
+    epoll_event stop_event = MakeEvent(EPOLLIN, STOP_EVENT_ID);
+    if (epoll_fd_ < 0 || stop_fd_ < 0 || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &listen_event) != 0
+        || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, stop_fd_, &stop_event) != 0) {
+        for (const int fd : { listen_fd_, epoll_fd_, stop_fd_ }) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+        throw std::runtime_error("Cannot set up the event loop"s);
+    }
+    SetNonBlocking(listen_fd_);
+    next_connection_id_ = STOP_EVENT_ID + 1;
+}
+
+SearchDaemon::~SearchDaemon() {
+    for (const auto& [connection_id, connection] : connections_) {
+        close(connection.fd);
+    }
+    close(listen_fd_);
+    close(epoll_fd_);
+    close(stop_fd_);
+    unlink(socket_path_.c_str());
+}
+
+// Each round reads whatever every ready connection has sent, answers all of it, and writes
+// the responses back; requests arriving meanwhile wait in the sockets for the next round.
+void SearchDaemon::Run() {
+    epoll_event events[MAX_EVENT_COUNT];
+    while (true) {
+        const int event_count = epoll_wait(epoll_fd_, events, MAX_EVENT_COUNT, -1);
+        if (event_count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Cannot wait for events"s);
+        }
+        for (int i = 0; i < event_count; ++i) {
+            const uint64_t event_id = events[i].data.u64;
+            if (event_id == STOP_EVENT_ID) {
+                return;
+            }
+            if (event_id == LISTEN_EVENT_ID) {
+                Accept();
+                continue;
+            }
+            const auto connection_it = connections_.find(event_id);
+            if (connection_it == connections_.end()) {
+                continue;
+            }
+            // Output is written to every connection below, whether or not this was an EPOLLOUT.
+            if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0) {
+                Read(event_id, connection_it->second);
+            }
+        }
+        ExecuteRequests();
+        for (auto connection_it = connections_.begin(); connection_it != connections_.end();) {
+            const uint64_t connection_id = connection_it->first;
+            Connection& connection = connection_it->second;
+            ++connection_it;
+            Write(connection_id, connection);
+        }
+    }
+}
+
+void SearchDaemon::Stop() {
+    const uint64_t value = 1;
+    while (write(stop_fd_, &value, sizeof(value)) < 0 && errno == EINTR) {
+    }
+}
+
+SearchDaemonStats SearchDaemon::GetStats() const {
+    std::lock_guard lock(stats_mutex_);
+    return stats_;
+}
+
+void SearchDaemon::Accept() {
+    while (true) {
+        const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        const uint64_t connection_id = next_connection_id_++;
+        epoll_event event = MakeEvent(EPOLLIN, connection_id);
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            continue;
+        }
+        connections_[connection_id].fd = fd;
+        std::lock_guard lock(stats_mutex_);
+        ++stats_.connection_count;
+    }
+}
+
+void SearchDaemon::Read(uint64_t connection_id, Connection& connection) {
+    while (true) {
+        const size_t old_size = connection.input.size();
+        connection.input.resize(old_size + RECEIVE_BUFFER_SIZE);
+        const ssize_t size = read(connection.fd, connection.input.data() + old_size, RECEIVE_BUFFER_SIZE);
+        connection.input.resize(old_size + std::max<ssize_t>(size, 0));
+        if (size > 0) {
+            continue;
+        }
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size == 0 || errno != EAGAIN) {
+            // The peer is gone; its requests still queued are answered into the void.
+            connection.closing = true;
+        }
+        break;
+    }
+
+    size_t line_begin = 0;
+    for (size_t line_end; (line_end = connection.input.find('\n', line_begin)) != std::string::npos; line_begin = line_end + 1) {
+        std::string_view line(connection.input.data() + line_begin, line_end - line_begin);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        requests_.push_back({ connection_id, std::string(line) });
+    }
+    connection.input.erase(0, line_begin);
+    if (connection.input.size() > MAX_LINE_SIZE) {
+        requests_.push_back({ connection_id, {} });
+        connection.input.clear();
+        connection.closing = true;
+    }
+}
+
+void SearchDaemon::Write(uint64_t connection_id, Connection& connection) {
+    size_t written = 0;
+    while (written < connection.output.size()) {
+        const ssize_t size = send(connection.fd, connection.output.data() + written, connection.output.size() - written, MSG_NOSIGNAL);
+        if (size > 0) {
+            written += size;
+            continue;
+        }
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size < 0 && errno != EAGAIN) {
+            Close(connection_id);
+            return;
+        }
+        break;
+    }
+    connection.output.erase(0, written);
+    if (connection.closing && connection.output.empty()) {
+        Close(connection_id);
+        return;
+    }
+    UpdateEvents(connection_id, connection);
+}
+
+void SearchDaemon::UpdateEvents(uint64_t connection_id, Connection& connection) {
+    const bool writing = !connection.output.empty();
+    const bool reading = !connection.closing && connection.output.size() < options_.max_pending_output;
+    if (writing == connection.writing && reading == connection.reading) {
+        return;
+    }
+    epoll_event event = MakeEvent((reading ? EPOLLIN : 0u) | (writing ? EPOLLOUT : 0u), connection_id);
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &event);
+    connection.writing = writing;
+    connection.reading = reading;
+}
+
+void SearchDaemon::Close(uint64_t connection_id) {
+    const auto connection_it = connections_.find(connection_id);
+    close(connection_it->second.fd);
+    connections_.erase(connection_it);
+}
+
+// Queries in a row are answered as one batch; a write ends the batch, so every request sees
+// the writes sent before it on any connection, and none after.
+void SearchDaemon::ExecuteRequests() {
+    std::vector<uint64_t> query_connection_ids;
+    std::vector<std::string> queries;
+    std::vector<std::string> responses;
+    while (!requests_.empty()) {
+        queries.clear();
+        query_connection_ids.clear();
+        while (!requests_.empty() && queries.size() < options_.max_batch_size && requests_.front().line.compare(0, 6, "QUERY "sv) == 0) {
+            query_connection_ids.push_back(requests_.front().connection_id);
+            queries.push_back(requests_.front().line.substr(6));
+            requests_.pop_front();
+        }
+        if (!queries.empty()) {
+            responses.assign(queries.size(), {});
+            std::transform(std::execution::par, queries.begin(), queries.end(), responses.begin(), [this](const std::string& query) {
+                try {
+                    return FormatDocuments(search_server_.FindTopDocuments(query));
+                }
+                catch (const std::exception& error) {
+                    return "ERROR "s + error.what();
+                }
+                });
+            for (size_t i = 0; i < queries.size(); ++i) {
+                Respond(query_connection_ids[i], responses[i]);
+            }
+            std::lock_guard lock(stats_mutex_);
+            stats_.request_count += queries.size();
+            stats_.query_count += queries.size();
+            ++stats_.batch_count;
+            continue;
+        }
+
+        const Request request = std::move(requests_.front());
+        requests_.pop_front();
+        std::string_view arguments = request.line;
+        const std::string_view command = TakeWord(arguments);
+        std::string response;
+        try {
+            response = ExecuteWrite(command, arguments);
+        }
+        catch (const std::exception& error) {
+            response = "ERROR "s + error.what();
+        }
+        Respond(request.connection_id, response);
+        std::lock_guard lock(stats_mutex_);
+        ++stats_.request_count;
+    }
+}
+
+std::string SearchDaemon::ExecuteWrite(std::string_view command, std::string_view arguments) {
+    if (command == "ADD"sv) {
+        const int document_id = ParseInt(TakeWord(arguments));
+        std::string_view ratings_text = TakeWord(arguments);
+        std::vector<int> ratings;
+        while (ratings_text != "-"sv && !ratings_text.empty()) {
+            const size_t end = std::min(ratings_text.find(','), ratings_text.size());
+            ratings.push_back(ParseInt(ratings_text.substr(0, end)));
+            ratings_text.remove_prefix(std::min(end + 1, ratings_text.size()));
+        }
+        search_server_.AddDocument(document_id, arguments, DocumentStatus::ACTUAL, ratings);
+        return "OK"s;
+    }
+    if (command == "REMOVE"sv) {
+        search_server_.RemoveDocument(ParseInt(arguments));
+        return "OK"s;
+    }
+    throw std::invalid_argument("Unknown request"s);
+}
+
+void SearchDaemon::Respond(uint64_t connection_id, const std::string& response) {
+    const auto connection_it = connections_.find(connection_id);
+    if (connection_it != connections_.end()) {
+        connection_it->second.output += response;
+        connection_it->second.output += '\n';
+    }
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "search_server.h"
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct SearchDaemonOptions {
+    // Most queries answered together in one parallel batch.
+    size_t max_batch_size = 256;
+    // A connection is not read while this much output waits for it.
+    size_t max_pending_output = 4u << 20;
+};
+
+// query_count / batch_count is how many queries arrived together on average.
+struct SearchDaemonStats {
+    uint64_t connection_count = 0;
+    uint64_t request_count = 0;
+    uint64_t query_count = 0;
+    uint64_t batch_count = 0;
+};
+
+// Serves a SearchServer over a Unix domain socket with a line protocol, one request per line
+// and one response line per request, in request order on each connection:
+//   QUERY <query>              -> OK <count> followed by <id> <relevance> <rating> per document
+//   ADD <id> <ratings> <text>  -> OK; ratings are comma-separated, or "-" for none
+//   REMOVE <id>                -> OK
+// and ERROR <message> for a request that fails. Clients may pipeline: send more requests
+// before reading responses. One epoll loop reads every connection that has input; the
+// queries that arrived together run as one parallel batch, like ProcessQueries, and the
+// writes between them run alone in arrival order, so no lock is needed.
+class SearchDaemon {
+public:
+    SearchDaemon(SearchServer& search_server, const std::string& socket_path, SearchDaemonOptions options = {});
+    ~SearchDaemon();
+    SearchDaemon(const SearchDaemon&) = delete;
+    SearchDaemon& operator=(const SearchDaemon&) = delete;
+
+    // Returns after Stop.
+    void Run();
+    // May be called from any thread, or from a signal handler.
+    void Stop();
+
+    SearchDaemonStats GetStats() const;
+
+private:
+    struct Connection {
+        int fd = -1;
+        std::string input;
+        std::string output;
+        // Whether epoll watches the connection for output, and for input.
+        bool writing = false;
+        bool reading = true;
+        bool closing = false;
+    };
+
+    struct Request {
+        uint64_t connection_id;
+        std::string line;
+    };
+
+    void Accept();
+    void Read(uint64_t connection_id, Connection& connection);
+    void Write(uint64_t connection_id, Connection& connection);
+    void UpdateEvents(uint64_t connection_id, Connection& connection);
+    void Close(uint64_t connection_id);
+    void ExecuteRequests();
+    std::string ExecuteWrite(std::string_view command, std::string_view arguments);
+    void Respond(uint64_t connection_id, const std::string& response);
+
+    SearchServer& search_server_;
+    const std::string socket_path_;
+    const SearchDaemonOptions options_;
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int stop_fd_ = -1;
+
+    std::map<uint64_t, Connection> connections_;
+    uint64_t next_connection_id_ = 0;
+    std::deque<Request> requests_;
+
+    mutable std::mutex stats_mutex_;
+    SearchDaemonStats stats_;
+};
\ No newline at end of file
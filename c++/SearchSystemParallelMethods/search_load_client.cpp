@@ -0,0 +1,154 @@
+#include "search_load_client.h"
+
+#include "unix_socket.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#include <unistd.h>
+
+using namespace std::literals;
+
+namespace {
+
+constexpr size_t RECEIVE_BUFFER_SIZE = 64 * 1024;
+
+struct ConnectionResult {
+    size_t error_count = 0;
+    double total_relevance = 0;
+    std::vector<std::chrono::nanoseconds> latencies;
+};
+
+// Adds up the relevances of an "OK <count> (<id> <relevance> <rating>)..." line.
+double SumRelevance(std::string_view line) {
+    double total_relevance = 0;
+    const char* position = line.data() + 3;
+    const char* end = line.data() + line.size();
+    size_t count = 0;
+    position = std::from_chars(position, end, count).ptr;
+    for (size_t i = 0; i < count && position < end; ++i) {
+        int id;
+        double relevance;
+        position = std::from_chars(position + 1, end, id).ptr;
+        position = std::from_chars(position + 1, end, relevance).ptr;
+        total_relevance += relevance;
+        position = std::from_chars(position + 1, end, id).ptr;
+    }
+    return total_relevance;
+}
+
+ConnectionResult RunConnection(const std::string& socket_path, const std::vector<std::string>& queries, size_t first_query,
+    size_t request_count, size_t pipeline_depth) {
+    ConnectionResult result;
+    const int fd = ConnectUnixSocket(socket_path);
+    std::deque<std::chrono::steady_clock::time_point> send_times;
+    std::string request;
+    std::string input;
+    size_t sent_count = 0;
+    const auto send_requests = [&] {
+        request.clear();
+        while (sent_count < request_count && send_times.size() < pipeline_depth) {
+            request += "QUERY "s;
+            request += queries[(first_query + sent_count) % queries.size()];
+            request += '\n';
+            send_times.push_back(std::chrono::steady_clock::now());
+            ++sent_count;
+        }
+        SendAll(fd, request);
+    };
+
+    try {
+        send_requests();
+        while (!send_times.empty()) {
+            const size_t old_size = input.size();
+            input.resize(old_size + RECEIVE_BUFFER_SIZE);
+            const ssize_t size = read(fd, input.data() + old_size, RECEIVE_BUFFER_SIZE);
+            input.resize(old_size + std::max<ssize_t>(size, 0));
+            if (size < 0 && errno == EINTR) {
+                continue;
+            }
+            if (size <= 0) {
+                throw std::runtime_error("Search daemon closed the connection"s);
+            }
+            size_t line_begin = 0;
+            for (size_t line_end; (line_end = input.find('\n', line_begin)) != std::string::npos; line_begin = line_end + 1) {
+                const std::string_view line(input.data() + line_begin, line_end - line_begin);
+                result.latencies.push_back(std::chrono::steady_clock::now() - send_times.front());
+                send_times.pop_front();
+                if (line.substr(0, 3) == "OK "sv) {
+                    result.total_relevance += SumRelevance(line);
+                }
+                else {
+                    ++result.error_count;
+                }
+            }
+            input.erase(0, line_begin);
+            send_requests();
+        }
+    }
+    catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+    return result;
+}
+
+} // namespace
+
+double LoadClientResult::GetThroughput() const {
+    return duration.count() == 0 ? 0.0 : request_count * 1e9 / duration.count();
+}
+
+std::chrono::nanoseconds LoadClientResult::GetLatencyPercentile(double percentile) const {
+    if (latencies.empty()) {
+        return {};
+    }
+    return latencies[std::min(latencies.size() - 1, static_cast<size_t>(latencies.size() * percentile / 100))];
+}
+
+LoadClientResult RunLoadClient(const std::string& socket_path, const std::vector<std::string>& queries, LoadClientOptions options) {
+    if (queries.empty() || options.connection_count == 0 || options.pipeline_depth == 0) {
+        throw std::invalid_argument("Invalid load client options"s);
+    }
+    std::vector<ConnectionResult> connection_results(options.connection_count);
+    std::vector<std::exception_ptr> errors(options.connection_count);
+    std::vector<std::thread> threads;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t connection = 0; connection < options.connection_count; ++connection) {
+        const size_t first_request = options.request_count * connection / options.connection_count;
+        const size_t request_count = options.request_count * (connection + 1) / options.connection_count - first_request;
+        threads.emplace_back([&, connection, first_request, request_count] {
+            try {
+                connection_results[connection] = RunConnection(socket_path, queries, first_request, request_count, options.pipeline_depth);
+            }
+            catch (...) {
+                errors[connection] = std::current_exception();
+            }
+            });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    LoadClientResult result;
+    result.duration = std::chrono::steady_clock::now() - start;
+    for (size_t connection = 0; connection < options.connection_count; ++connection) {
+        if (errors[connection]) {
+            std::rethrow_exception(errors[connection]);
+        }
+        const ConnectionResult& connection_result = connection_results[connection];
+        result.request_count += connection_result.latencies.size();
+        result.error_count += connection_result.error_count;
+        result.total_relevance += connection_result.total_relevance;
+        result.latencies.insert(result.latencies.end(), connection_result.latencies.begin(), connection_result.latencies.end());
+    }
+    std::sort(result.latencies.begin(), result.latencies.end());
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+struct LoadClientOptions {
+    size_t connection_count = 4;
+    // Requests each connection keeps in flight.
+    size_t pipeline_depth = 8;
+    // Requests over all connections; the queries are sent round robin.
+    size_t request_count = 10000;
+};
+
+struct LoadClientResult {
+    size_t request_count = 0;
+    size_t error_count = 0;
+    // Sum of every document's relevance in every response, to check the answers against.
+    double total_relevance = 0;
+    std::chrono::nanoseconds duration{};
+    // Sorted.
+    std::vector<std::chrono::nanoseconds> latencies;
+
+    double GetThroughput() const;
+    std::chrono::nanoseconds GetLatencyPercentile(double percentile) const;
+};
+
+// Drives a SearchDaemon with QUERY requests from connection_count threads, one connection
+// each, and measures the time from sending a request to reading its response.
+LoadClientResult RunLoadClient(const std::string& socket_path, const std::vector<std::string>& queries, LoadClientOptions options = {});
\ No newline at end of file
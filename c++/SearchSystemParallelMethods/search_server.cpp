@@ -1,28 +1,135 @@
 #include "search_server.h"
 
-SearchServer::SearchServer(std::string_view stop_words_text) : SearchServer(SplitIntoWords(stop_words_text)) {
+#include "file_sync.h"
+#include "index_format.h"
+#include "mapped_search_server.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+SearchServer::SearchServer(std::string_view stop_words_text, TermFreqStorage term_freq_storage, IndexHugePages huge_pages)
+    : SearchServer(SplitIntoWords(stop_words_text), term_freq_storage, huge_pages) {
 
 }
 
-SearchServer::SearchServer(const std::string& stop_words_text) : SearchServer(SplitIntoWords(stop_words_text)) {
+SearchServer::SearchServer(const std::string& stop_words_text, TermFreqStorage term_freq_storage, IndexHugePages huge_pages)
+    : SearchServer(SplitIntoWords(stop_words_text), term_freq_storage, huge_pages) {
 
 }
 
+// Documents are rebuilt from the forward index, in slot order; the word counts come back from
+// the stored term frequencies, which are count / length in DOUBLE and FLOAT storage.
+SearchServer::SearchServer(const MappedSearchServer& saved_index, IndexHugePages huge_pages)
+    : SearchServer(saved_index.stop_words_, saved_index.term_freq_storage_, huge_pages) {
+    const IndexFileHeader& header = *saved_index.header_;
+    std::vector<TokenizedDocument> documents(header.slot_count);
+    for (uint32_t slot = 0; slot < header.slot_count; ++slot) {
+        documents[slot] = { saved_index.document_ids_[slot], saved_index.document_statuses_[slot], saved_index.document_ratings_[slot],
+            saved_index.document_word_counts_[slot], {} };
+    }
+    for (uint32_t term = 0; term < header.term_count; ++term) {
+        const std::string word(saved_index.GetTerm(term));
+        for (uint64_t i = saved_index.posting_offsets_[term]; i < saved_index.posting_offsets_[term + 1]; ++i) {
+            const uint32_t slot = saved_index.posting_slots_[i];
+            int count = 0;
+            switch (term_freq_storage_) {
+            case TermFreqStorage::DOUBLE:
+                count = static_cast<int>(std::lround(saved_index.term_freqs_[i] * documents[slot].word_count));
+                break;
+            case TermFreqStorage::FLOAT:
+                count = static_cast<int>(std::lround(saved_index.float_term_freqs_[i] * documents[slot].word_count));
+                break;
+            case TermFreqStorage::COUNT:
+                count = saved_index.word_counts_[i];
+                break;
+            }
+            documents[slot].word_counts.emplace_back(word, count);
+        }
+    }
+    for (const TokenizedDocument& document : documents) {
+        AddTokenizedDocument(document);
+    }
+}
+
 void SearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    AddTokenizedDocument(TokenizeDocument(document_id, document, status, ratings));
+}
 
-    if ((document_id < 0) || (documents_.count(document_id) > 0)) {
+TokenizedDocument SearchServer::TokenizeDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) const {
+    if (document_id < 0) {
         throw std::invalid_argument("Invalid document_id");
     }
-    const auto words = SplitIntoWordsNoStop(document);
+    auto words = SplitIntoWordsNoStop(document);
+    std::sort(words.begin(), words.end());
+
+    TokenizedDocument tokenized{ document_id, status, ComputeAverageRating(ratings), static_cast<int>(words.size()), {} };
+    for (auto& word : words) {
+        if (tokenized.word_counts.empty() || tokenized.word_counts.back().first != word) {
+            tokenized.word_counts.emplace_back(std::move(word), 0);
+        }
+        ++tokenized.word_counts.back().second;
+    }
+    if (term_freq_storage_ == TermFreqStorage::COUNT) {
+        for (const auto& [word, count] : tokenized.word_counts) {
+            if (count > std::numeric_limits<uint16_t>::max()) {
+                throw std::invalid_argument("Word "s + word + " occurs too often for COUNT storage"s);
+            }
+        }
+    }
+    return tokenized;
+}
+
+void SearchServer::AddTokenizedDocument(const TokenizedDocument& document) {
+    // The id is claimed in document_ids_ before any word is interned, so a rejected document
+    // leaves nothing behind in the term dictionary.
+    {
+        std::lock_guard guard(document_mutex_);
+        if ((document.id < 0) || !document_ids_.insert(document.id).second) {
+            throw std::invalid_argument("Invalid document_id");
+        }
+    }
+
+    // Words are interned next, so that the slot, the columns and the forward index of the
+    // document are written in one short critical section.
+    std::vector<std::pair<TermStripe*, std::string_view>> stored_words;
+    try {
+        stored_words.reserve(document.word_counts.size());
+        for (const auto& [word, count] : document.word_counts) {
+            TermStripe& stripe = GetTermStripe(word);
+            std::lock_guard guard(stripe.mutex);
+            stored_words.emplace_back(&stripe, InternWord(stripe, word));
+        }
+    }
+    catch (...) {
+        std::lock_guard guard(document_mutex_);
+        document_ids_.erase(document.id);
+        throw;
+    }
+
+    const double inv_word_count = 1.0 / document.word_count;
+    uint32_t slot;
+    {
+        std::lock_guard guard(document_mutex_);
+        slot = static_cast<uint32_t>(document_columns_.ids.size());
+        for (const auto& [stripe, stored_word] : stored_words) {
+            document_columns_.words.push_back(stored_word);
+        }
+        document_columns_.ids.push_back(document.id);
+        document_columns_.ratings.push_back(document.rating);
+        document_columns_.statuses.push_back(document.status);
+        document_columns_.word_counts.push_back(document.word_count);
+        document_columns_.inv_word_counts.push_back(inv_word_count);
+        document_columns_.word_offsets.push_back(document_columns_.words.size());
+        document_slots_.emplace(document.id, slot);
+        total_word_count_ += document.word_count;
+    }
 
-    const double inv_word_count = 1.0 / words.size();
-    for (const std::string& word : words) {
-        words_to_server_.insert(word);
-        word_to_document_freqs_[word][document_id] += inv_word_count;
-        document_to_word_freqs_[document_id][word] += inv_word_count;
+    for (size_t i = 0; i < stored_words.size(); ++i) {
+        const auto [stripe, stored_word] = stored_words[i];
+        std::lock_guard guard(stripe->mutex);
+        InsertPosting(stripe->postings[stored_word], slot, document.word_counts[i].second, inv_word_count);
     }
-    documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status });
-    document_ids_.insert(document_id);
 }
 
 
@@ -34,8 +141,64 @@ std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query)
     return SearchServer::FindTopDocuments(std::execution::seq, raw_query);
 }
 
+int SearchServer::CountMatches(std::string_view raw_query, DocumentStatus status) const {
+    return CountMatches(std::execution::seq, raw_query, status);
+}
+
+int SearchServer::CountMatches(std::string_view raw_query) const {
+    return CountMatches(std::execution::seq, raw_query);
+}
+
+void SearchServer::OrderPage(std::vector<Document>& top_documents, const PageRequest& page) {
+    std::sort(top_documents.begin(), top_documents.end(), IsRankedHigher);
+    top_documents.erase(top_documents.begin(), top_documents.begin() + std::min(page.offset, top_documents.size()));
+}
+
 int SearchServer::GetDocumentCount() const {
-    return documents_.size();
+    return document_slots_.size();
+}
+
+bool SearchServer::ContainsDocument(int document_id) const {
+    return document_slots_.count(document_id) > 0;
+}
+
+CorpusStats SearchServer::GetCorpusStats() const {
+    const int document_count = GetDocumentCount();
+    return { document_count, document_count == 0 ? 0.0 : total_word_count_ * 1.0 / document_count };
+}
+
+void SearchServer::AddTermStats(std::string_view raw_query, TermStats& term_stats) const {
+    term_stats.document_count += GetDocumentCount();
+    term_stats.total_word_count += total_word_count_;
+    for (const auto& word : ParseQuery(raw_query).plus_words) {
+        const PostingList* postings = FindPostings(word);
+        const int document_freq = postings == nullptr ? 0 : static_cast<int>(postings->slots.size());
+        const auto freq_it = term_stats.document_freqs.find(std::string_view(word));
+        if (freq_it == term_stats.document_freqs.end()) {
+            term_stats.document_freqs.emplace(word, document_freq);
+        }
+        else {
+            freq_it->second += document_freq;
+        }
+    }
+}
+
+void SearchServer::AddDocumentTermStats(int document_id, TermStats& term_stats) const {
+    const auto slot_it = document_slots_.find(document_id);
+    if (slot_it == document_slots_.end()) {
+        return;
+    }
+    ++term_stats.document_count;
+    term_stats.total_word_count += document_columns_.word_counts[slot_it->second];
+    for (const std::string_view word : GetSlotWords(slot_it->second)) {
+        const auto freq_it = term_stats.document_freqs.find(word);
+        if (freq_it == term_stats.document_freqs.end()) {
+            term_stats.document_freqs.emplace(word, 1);
+        }
+        else {
+            ++freq_it->second;
+        }
+    }
 }
 
 std::set<int>::iterator SearchServer::begin() {
@@ -46,12 +209,41 @@ std::set<int>::iterator SearchServer::end() {
     return document_ids_.end();
 }
 
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    static std::map<std::string_view, double> empty_word_freqs_;
-    if (document_ids_.count(document_id) == 0) {
-        return empty_word_freqs_;
+IndexMemoryStats SearchServer::GetIndexMemoryStats() const {
+    IndexMemoryStats stats;
+    for (const auto& stripe : term_stripes_) {
+        for (const auto& [word, postings] : stripe->postings) {
+            stats.posting_count += postings.slots.size();
+            stats.posting_bytes += postings.slots.capacity() * sizeof(uint32_t)
+                + postings.term_freqs.capacity() * sizeof(double)
+                + postings.float_term_freqs.capacity() * sizeof(float)
+                + postings.word_counts.capacity() * sizeof(uint16_t);
+        }
     }
-    return document_to_word_freqs_.at(document_id);
+    stats.forward_index_bytes = document_columns_.word_offsets.capacity() * sizeof(size_t)
+        + document_columns_.words.capacity() * sizeof(std::string_view);
+    stats.document_column_bytes = document_columns_.ids.capacity() * sizeof(int)
+        + document_columns_.ratings.capacity() * sizeof(int)
+        + document_columns_.statuses.capacity() * sizeof(DocumentStatus)
+        + document_columns_.word_counts.capacity() * sizeof(int)
+        + document_columns_.inv_word_counts.capacity() * sizeof(double);
+    stats.arena = index_arena_.GetStats();
+    return stats;
+}
+
+std::map<std::string_view, double> SearchServer::GetWordFrequencies(int document_id) const {
+    std::map<std::string_view, double> word_freqs;
+    const auto slot_it = document_slots_.find(document_id);
+    if (slot_it == document_slots_.end()) {
+        return word_freqs;
+    }
+    const uint32_t slot = slot_it->second;
+    for (const std::string_view word : GetSlotWords(slot)) {
+        const PostingList& postings = *FindPostings(word);
+        const auto index = std::lower_bound(postings.slots.begin(), postings.slots.end(), slot) - postings.slots.begin();
+        word_freqs.emplace(word, GetTermFreq(postings, index));
+    }
+    return word_freqs;
 }
 
 void SearchServer::RemoveDocument(int document_id) {
@@ -62,12 +254,160 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
     return SearchServer::MatchDocument(std::execution::seq, raw_query, document_id);
 }
 
-bool SearchServer::IsStopWord(const std::string& word) const {
+SearchServer::TermStripe& SearchServer::GetTermStripe(std::string_view word) const {
+    return *term_stripes_[std::hash<std::string_view>{}(word) % TERM_STRIPE_COUNT];
+}
+
+std::string_view SearchServer::InternWord(TermStripe& stripe, std::string_view word) {
+    auto stored_word_it = stripe.words.find(word);
+    if (stored_word_it == stripe.words.end()) {
+        stored_word_it = stripe.words.emplace(word).first;
+    }
+    return *stored_word_it;
+}
+
+const SearchServer::PostingList* SearchServer::FindPostings(std::string_view word) const {
+    const auto& stripe_postings = GetTermStripe(word).postings;
+    const auto postings_it = stripe_postings.find(word);
+    return postings_it == stripe_postings.end() ? nullptr : &postings_it->second;
+}
+
+SearchServer::PostingView SearchServer::GetPostingView(std::string_view word) const {
+    const PostingList* postings = FindPostings(word);
+    if (postings == nullptr) {
+        return {};
+    }
+    return { postings->slots.data(), postings->term_freqs.data(), postings->float_term_freqs.data(), postings->word_counts.data(), postings->slots.size() };
+}
+
+SearchServer::IndexView SearchServer::GetIndexView() const {
+    return { term_freq_storage_, document_columns_.ids.size(), document_columns_.ids.data(), document_columns_.ratings.data(),
+        document_columns_.statuses.data(), document_columns_.word_counts.data(), document_columns_.inv_word_counts.data() };
+}
+
+// Concurrent writers take slots in one order but may reach a shared posting list in another,
+// so a slot goes to its sorted position; that is nearly always the end.
+void SearchServer::InsertPosting(PostingList& postings, uint32_t slot, int count, double inv_word_count) const {
+    const size_t index = postings.slots.empty() || postings.slots.back() < slot ? postings.slots.size()
+        : std::upper_bound(postings.slots.begin(), postings.slots.end(), slot) - postings.slots.begin();
+    postings.slots.insert(postings.slots.begin() + index, slot);
+    switch (term_freq_storage_) {
+    case TermFreqStorage::DOUBLE:
+        postings.term_freqs.insert(postings.term_freqs.begin() + index, count * inv_word_count);
+        break;
+    case TermFreqStorage::FLOAT:
+        postings.float_term_freqs.insert(postings.float_term_freqs.begin() + index, static_cast<float>(count * inv_word_count));
+        break;
+    case TermFreqStorage::COUNT:
+        postings.word_counts.insert(postings.word_counts.begin() + index, static_cast<uint16_t>(count));
+        break;
+    }
+}
+
+IteratorRange<const std::string_view*> SearchServer::GetSlotWords(uint32_t slot) const {
+    const std::string_view* words = document_columns_.words.data();
+    return { words + document_columns_.word_offsets[slot], words + document_columns_.word_offsets[slot + 1] };
+}
+
+void SearchServer::EraseSlot(PostingList& postings, uint32_t slot) {
+    const auto slot_it = std::lower_bound(postings.slots.begin(), postings.slots.end(), slot);
+    if (slot_it == postings.slots.end() || *slot_it != slot) {
+        return;
+    }
+    const auto offset = slot_it - postings.slots.begin();
+    postings.slots.erase(slot_it);
+    if (!postings.term_freqs.empty()) {
+        postings.term_freqs.erase(postings.term_freqs.begin() + offset);
+    }
+    if (!postings.float_term_freqs.empty()) {
+        postings.float_term_freqs.erase(postings.float_term_freqs.begin() + offset);
+    }
+    if (!postings.word_counts.empty()) {
+        postings.word_counts.erase(postings.word_counts.begin() + offset);
+    }
+}
+
+void SearchServer::CompactSlots() {
+    constexpr uint32_t REMOVED_SLOT = std::numeric_limits<uint32_t>::max();
+    const uint32_t slot_count = static_cast<uint32_t>(document_columns_.ids.size());
+    std::vector<uint32_t> slot_map(slot_count, REMOVED_SLOT);
+    for (auto& [document_id, slot] : document_slots_) {
+        slot_map[slot] = 0;
+    }
+
+    // Live slots only move down, so each column is compacted in place front to back.
+    DocumentColumns& columns = document_columns_;
+    uint32_t new_slot = 0;
+    size_t word_end = 0;
+    for (uint32_t slot = 0; slot < slot_count; ++slot) {
+        if (slot_map[slot] == REMOVED_SLOT) {
+            continue;
+        }
+        slot_map[slot] = new_slot;
+        columns.ids[new_slot] = columns.ids[slot];
+        columns.ratings[new_slot] = columns.ratings[slot];
+        columns.statuses[new_slot] = columns.statuses[slot];
+        columns.word_counts[new_slot] = columns.word_counts[slot];
+        columns.inv_word_counts[new_slot] = columns.inv_word_counts[slot];
+        word_end = std::copy(columns.words.begin() + columns.word_offsets[slot], columns.words.begin() + columns.word_offsets[slot + 1],
+            columns.words.begin() + word_end) - columns.words.begin();
+        columns.word_offsets[new_slot + 1] = word_end;
+        ++new_slot;
+    }
+    columns.ids.resize(new_slot);
+    columns.ratings.resize(new_slot);
+    columns.statuses.resize(new_slot);
+    columns.word_counts.resize(new_slot);
+    columns.inv_word_counts.resize(new_slot);
+    columns.word_offsets.resize(new_slot + 1);
+    columns.words.resize(word_end);
+    columns.ids.shrink_to_fit();
+    columns.ratings.shrink_to_fit();
+    columns.statuses.shrink_to_fit();
+    columns.word_counts.shrink_to_fit();
+    columns.inv_word_counts.shrink_to_fit();
+    columns.word_offsets.shrink_to_fit();
+    columns.words.shrink_to_fit();
+
+    for (auto& [document_id, slot] : document_slots_) {
+        slot = slot_map[slot];
+    }
+    for (const auto& stripe : term_stripes_) {
+        for (auto& [word, postings] : stripe->postings) {
+            for (uint32_t& slot : postings.slots) {
+                slot = slot_map[slot];
+            }
+        }
+    }
+}
+
+void SearchServer::DecodeTermFreqs(const IndexView& index, const PostingView& postings, size_t begin, size_t end, double* term_freqs) {
+    if (index.term_freq_storage == TermFreqStorage::FLOAT) {
+        std::copy(postings.float_term_freqs + begin, postings.float_term_freqs + end, term_freqs);
+        return;
+    }
+    for (size_t i = begin; i < end; ++i) {
+        *term_freqs++ = postings.word_counts[i] * index.inv_word_counts[postings.slots[i]];
+    }
+}
+
+double SearchServer::GetTermFreq(const PostingList& postings, size_t index) const {
+    switch (term_freq_storage_) {
+    case TermFreqStorage::FLOAT:
+        return postings.float_term_freqs[index];
+    case TermFreqStorage::COUNT:
+        return postings.word_counts[index] * document_columns_.inv_word_counts[postings.slots[index]];
+    default:
+        return postings.term_freqs[index];
+    }
+}
+
+bool SearchServer::IsStopWord(std::string_view word) const {
     return stop_words_.count(word) > 0;
 }
 
-bool SearchServer::IsValidWord(const std::string& word) {
-    return none_of(word.begin(), word.end(), [](char c) {
+bool SearchServer::IsValidWord(std::string_view word) {
+    return std::none_of(word.begin(), word.end(), [](char c) {
         return c >= '\0' && c < ' ';
         });
 }
@@ -96,40 +436,275 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
     return rating_sum / static_cast<int>(ratings.size());
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(const std::string& text) const {
+SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text, const std::set<std::string, std::less<>>& stop_words) {
 
     if (text.empty()) {
         throw std::invalid_argument("Query word is empty"s);
     }
-    std::string word = text;
+    std::string_view word = text;
     bool is_minus = false;
     if (word[0] == '-') {
         is_minus = true;
-        word = word.substr(1);
+        word.remove_prefix(1);
     }
     if (word.empty() || word[0] == '-' || !IsValidWord(word)) {
-        throw std::invalid_argument("Query word "s + text + " is invalid"s);
+        throw std::invalid_argument("Query word "s + std::string(text) + " is invalid"s);
     }
 
-    return { word, is_minus, IsStopWord(word) };
+    return { word, is_minus, stop_words.count(word) > 0 };
 }
 
 SearchServer::Query SearchServer::ParseQuery(std::string_view text) const {
-    Query result;
-    for (const std::string& word : SplitIntoWords(text)) {
-        const auto query_word = ParseQueryWord(word);
+    ScratchLease scratch;
+    return ParseQuery(text, scratch->tokens, std::pmr::get_default_resource());
+}
+
+SearchServer::Query SearchServer::ParseQuery(std::string_view text, std::vector<std::string>& tokens, std::pmr::memory_resource* resource) const {
+    return ParseQuery(text, stop_words_, tokens, resource);
+}
+
+SearchServer::Query SearchServer::ParseQuery(std::string_view text, const std::set<std::string, std::less<>>& stop_words, std::vector<std::string>& tokens,
+    std::pmr::memory_resource* resource) {
+    Query result(resource);
+    SplitIntoWords(text, tokens);
+    for (const std::string& word : tokens) {
+        const auto query_word = ParseQueryWord(word, stop_words);
         if (!query_word.is_stop) {
             if (query_word.is_minus) {
-                result.minus_words.insert(query_word.data);
+                result.minus_words.emplace(query_word.data);
             }
             else {
-                result.plus_words.insert(query_word.data);
+                result.plus_words.emplace(query_word.data);
             }
         }
     }
     return result;
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(const std::string& word) const {
-    return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+void SearchServer::AppendDocuments(const SearchServer& other, const std::set<int>& skipped_document_ids) {
+    if (other.term_freq_storage_ != term_freq_storage_) {
+        throw std::invalid_argument("Cannot append documents stored with a different TermFreqStorage"s);
+    }
+    const uint32_t other_slot_count = static_cast<uint32_t>(other.document_columns_.ids.size());
+    for (uint32_t other_slot = 0; other_slot < other_slot_count; ++other_slot) {
+        const int document_id = other.document_columns_.ids[other_slot];
+        if (other.document_slots_.count(document_id) > 0 && skipped_document_ids.count(document_id) == 0 && document_slots_.count(document_id) > 0) {
+            throw std::invalid_argument("Invalid document_id");
+        }
+    }
+
+    // Each word of other is interned once; its forward index entries are translated through this map.
+    std::unordered_map<const char*, std::string_view> stored_words;
+    const auto store_word = [this, &stored_words](std::string_view word) {
+        const auto [stored_it, inserted] = stored_words.emplace(word.data(), std::string_view());
+        if (inserted) {
+            stored_it->second = InternWord(GetTermStripe(word), word);
+        }
+        return stored_it->second;
+    };
+
+    // Appended slots keep their relative order, so every posting list stays sorted.
+    constexpr uint32_t SKIPPED_SLOT = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> slot_map(other_slot_count, SKIPPED_SLOT);
+    for (uint32_t other_slot = 0; other_slot < other_slot_count; ++other_slot) {
+        const int document_id = other.document_columns_.ids[other_slot];
+        const auto other_slot_it = other.document_slots_.find(document_id);
+        if (other_slot_it == other.document_slots_.end() || other_slot_it->second != other_slot || skipped_document_ids.count(document_id) > 0) {
+            continue;
+        }
+        const uint32_t slot = static_cast<uint32_t>(document_columns_.ids.size());
+        slot_map[other_slot] = slot;
+        for (const std::string_view word : other.GetSlotWords(other_slot)) {
+            document_columns_.words.push_back(store_word(word));
+        }
+        document_columns_.ids.push_back(document_id);
+        document_columns_.ratings.push_back(other.document_columns_.ratings[other_slot]);
+        document_columns_.statuses.push_back(other.document_columns_.statuses[other_slot]);
+        document_columns_.word_counts.push_back(other.document_columns_.word_counts[other_slot]);
+        document_columns_.inv_word_counts.push_back(other.document_columns_.inv_word_counts[other_slot]);
+        document_columns_.word_offsets.push_back(document_columns_.words.size());
+        document_slots_.emplace(document_id, slot);
+        document_ids_.insert(document_id);
+        total_word_count_ += other.document_columns_.word_counts[other_slot];
+    }
+
+    for (const auto& other_stripe : other.term_stripes_) {
+        for (const auto& [other_word, other_postings] : other_stripe->postings) {
+            PostingList* postings = nullptr;
+            for (size_t i = 0; i < other_postings.slots.size(); ++i) {
+                const uint32_t slot = slot_map[other_postings.slots[i]];
+                if (slot == SKIPPED_SLOT) {
+                    continue;
+                }
+                if (postings == nullptr) {
+                    postings = &GetTermStripe(other_word).postings[store_word(other_word)];
+                }
+                postings->slots.push_back(slot);
+                switch (term_freq_storage_) {
+                case TermFreqStorage::DOUBLE:
+                    postings->term_freqs.push_back(other_postings.term_freqs[i]);
+                    break;
+                case TermFreqStorage::FLOAT:
+                    postings->float_term_freqs.push_back(other_postings.float_term_freqs[i]);
+                    break;
+                case TermFreqStorage::COUNT:
+                    postings->word_counts.push_back(other_postings.word_counts[i]);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void SearchServer::Save(const std::string& path) const {
+    std::vector<std::pair<std::string_view, const PostingList*>> terms;
+    for (const auto& stripe : term_stripes_) {
+        for (const auto& [word, postings] : stripe->postings) {
+            terms.emplace_back(word, &postings);
+        }
+    }
+    std::sort(terms.begin(), terms.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+        });
+    std::unordered_map<const char*, uint32_t> term_numbers;
+    for (const auto& [word, postings] : terms) {
+        term_numbers.emplace(word.data(), static_cast<uint32_t>(term_numbers.size()));
+    }
+
+    // Removed documents may still hold a slot in memory; the file leaves them out.
+    constexpr uint32_t REMOVED_SLOT = std::numeric_limits<uint32_t>::max();
+    const uint32_t slot_count = static_cast<uint32_t>(document_columns_.ids.size());
+    std::vector<uint32_t> slot_map(slot_count, REMOVED_SLOT);
+    std::vector<int32_t> ids;
+    std::vector<int32_t> ratings;
+    std::vector<int32_t> statuses;
+    std::vector<int32_t> word_counts;
+    std::vector<double> inv_word_counts;
+    std::vector<uint64_t> forward_offsets(1, 0);
+    std::vector<uint32_t> forward_terms;
+    for (uint32_t slot = 0; slot < slot_count; ++slot) {
+        const auto slot_it = document_slots_.find(document_columns_.ids[slot]);
+        if (slot_it == document_slots_.end() || slot_it->second != slot) {
+            continue;
+        }
+        slot_map[slot] = static_cast<uint32_t>(ids.size());
+        ids.push_back(document_columns_.ids[slot]);
+        ratings.push_back(document_columns_.ratings[slot]);
+        statuses.push_back(static_cast<int32_t>(document_columns_.statuses[slot]));
+        word_counts.push_back(document_columns_.word_counts[slot]);
+        inv_word_counts.push_back(document_columns_.inv_word_counts[slot]);
+        for (const std::string_view word : GetSlotWords(slot)) {
+            forward_terms.push_back(term_numbers.at(word.data()));
+        }
+        forward_offsets.push_back(forward_terms.size());
+    }
+    std::vector<uint32_t> sorted_id_slots(ids.size());
+    std::iota(sorted_id_slots.begin(), sorted_id_slots.end(), 0);
+    std::sort(sorted_id_slots.begin(), sorted_id_slots.end(), [&ids](uint32_t lhs, uint32_t rhs) {
+        return ids[lhs] < ids[rhs];
+        });
+    std::vector<int32_t> sorted_ids(ids.size());
+    std::transform(sorted_id_slots.begin(), sorted_id_slots.end(), sorted_ids.begin(), [&ids](uint32_t slot) {
+        return ids[slot];
+        });
+
+    std::vector<uint64_t> stop_word_offsets(1, 0);
+    std::string stop_word_chars;
+    for (const std::string& stop_word : stop_words_) {
+        stop_word_chars += stop_word;
+        stop_word_offsets.push_back(stop_word_chars.size());
+    }
+    std::vector<uint64_t> term_offsets(1, 0);
+    std::string term_chars;
+    std::vector<uint64_t> posting_offsets(1, 0);
+    for (const auto& [word, postings] : terms) {
+        term_chars += word;
+        term_offsets.push_back(term_chars.size());
+        posting_offsets.push_back(posting_offsets.back() + postings->slots.size());
+    }
+
+    IndexFileHeader header{};
+    std::memcpy(header.magic, INDEX_FILE_MAGIC, sizeof(header.magic));
+    header.version = INDEX_FILE_VERSION;
+    header.byte_order = INDEX_BYTE_ORDER_MARK;
+    header.term_freq_storage = static_cast<uint32_t>(term_freq_storage_);
+    header.stop_word_count = stop_words_.size();
+    header.term_count = terms.size();
+    header.posting_count = posting_offsets.back();
+    header.slot_count = ids.size();
+    header.forward_term_count = forward_terms.size();
+    header.total_word_count = total_word_count_;
+
+    const std::string temporary_path = path + ".tmp"s;
+    std::ofstream out(temporary_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot create index file "s + temporary_path);
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    const auto write_section = [&out, &header](IndexSection section, const auto& write_data) {
+        const char padding[INDEX_SECTION_ALIGNMENT] = {};
+        const uint64_t position = static_cast<uint64_t>(out.tellp());
+        IndexFileSection& file_section = header.sections[static_cast<size_t>(section)];
+        file_section.offset = (position + INDEX_SECTION_ALIGNMENT - 1) / INDEX_SECTION_ALIGNMENT * INDEX_SECTION_ALIGNMENT;
+        out.write(padding, file_section.offset - position);
+        write_data([&out](const void* data, size_t size) {
+            out.write(static_cast<const char*>(data), size);
+            });
+        file_section.size = static_cast<uint64_t>(out.tellp()) - file_section.offset;
+    };
+    const auto write_array = [&write_section](IndexSection section, const auto& values) {
+        write_section(section, [&values](const auto& write) {
+            write(values.data(), values.size() * sizeof(values[0]));
+            });
+    };
+
+    write_array(IndexSection::STOP_WORD_OFFSETS, stop_word_offsets);
+    write_array(IndexSection::STOP_WORD_CHARS, stop_word_chars);
+    write_array(IndexSection::TERM_OFFSETS, term_offsets);
+    write_array(IndexSection::TERM_CHARS, term_chars);
+    write_array(IndexSection::POSTING_OFFSETS, posting_offsets);
+    write_section(IndexSection::POSTING_SLOTS, [&](const auto& write) {
+        std::vector<uint32_t> slots;
+        for (const auto& [word, postings] : terms) {
+            slots.clear();
+            for (const uint32_t slot : postings->slots) {
+                slots.push_back(slot_map[slot]);
+            }
+            write(slots.data(), slots.size() * sizeof(uint32_t));
+        }
+        });
+    write_section(IndexSection::POSTING_TERM_FREQS, [&](const auto& write) {
+        for (const auto& [word, postings] : terms) {
+            write(postings->term_freqs.data(), postings->term_freqs.size() * sizeof(double));
+            write(postings->float_term_freqs.data(), postings->float_term_freqs.size() * sizeof(float));
+            write(postings->word_counts.data(), postings->word_counts.size() * sizeof(uint16_t));
+        }
+        });
+    write_array(IndexSection::DOCUMENT_IDS, ids);
+    write_array(IndexSection::DOCUMENT_RATINGS, ratings);
+    write_array(IndexSection::DOCUMENT_STATUSES, statuses);
+    write_array(IndexSection::DOCUMENT_WORD_COUNTS, word_counts);
+    write_array(IndexSection::DOCUMENT_INV_WORD_COUNTS, inv_word_counts);
+    write_array(IndexSection::FORWARD_OFFSETS, forward_offsets);
+    write_array(IndexSection::FORWARD_TERMS, forward_terms);
+    write_array(IndexSection::SORTED_IDS, sorted_ids);
+    write_array(IndexSection::SORTED_ID_SLOTS, sorted_id_slots);
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Cannot write index file "s + temporary_path);
+    }
+    // The contents reach the disk before the rename does, and the rename before Save returns,
+    // so a crash leaves either the old index or the whole new one under path.
+    SyncPath(temporary_path);
+    if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Cannot replace index file "s + path);
+    }
+    SyncParentDirectory(path);
+}
+
+MappedSearchServer SearchServer::OpenMapped(const std::string& path) {
+    return MappedSearchServer(path);
 }
\ No newline at end of file
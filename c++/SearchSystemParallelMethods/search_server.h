@@ -1,50 +1,209 @@
 #pragma once
 
-#include "concurrent_map.h"
 #include "document.h"
+#include "index_arena.h"
+#include "paginator.h"
 #include "read_input_functions.h"
+#include "scoring.h"
+#include "scoring_kernel.h"
 #include "string_processing.h"
+#include "thread_pool.h"
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <exception>
+#include <iterator>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <numeric>
+#include <optional>
 #include <stdexcept>
 #include <cassert>
 #include <tuple>
+#include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <execution>
 #include <future>
+#include <thread>
+#include <limits>
+
+using namespace std::literals;
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
+const double RELEVANCE_EPSILON = 1e-6;
+
+// Position in the result order (relevance desc, rating desc, id asc). Built from the
+// last document of a page and passed back to fetch the documents ranked after it.
+struct SearchCursor {
+    SearchCursor() = default;
+    explicit SearchCursor(const Document& last_document)
+        : relevance(last_document.relevance)
+        , rating(last_document.rating)
+        , id(last_document.id) {
+    }
+
+    double relevance = 0.0;
+    int rating = 0;
+    int id = 0;
+};
+
+struct PageRequest {
+    size_t offset = 0;
+    size_t limit = MAX_RESULT_DOCUMENT_COUNT;
+    std::optional<SearchCursor> search_after = std::nullopt;
+
+    // offset + limit, saturated so that a deep offset with a huge limit does not wrap around.
+    size_t GetEnd() const {
+        return limit > std::numeric_limits<size_t>::max() - offset ? std::numeric_limits<size_t>::max() : offset + limit;
+    }
+};
+
+// How postings keep term frequencies. Relevance is always computed in double;
+// the narrower modes only change what is stored and decoded per posting.
+//   DOUBLE - count / document length, 8 bytes per posting (reference path).
+//   FLOAT  - the same value rounded to float, 4 bytes per posting; relevance
+//            differs from DOUBLE by a relative error of at most 2^-24 (~6e-8).
+//   COUNT  - the raw count as uint16 plus one inverse length per document,
+//            2 bytes per posting; tf = count * (1 / length) is within 1e-15 relative
+//            of DOUBLE. A word may occur at most 65535 times in one document.
+enum class TermFreqStorage {
+    DOUBLE,
+    FLOAT,
+    COUNT,
+};
+
+struct IndexMemoryStats {
+    size_t posting_count = 0;
+    size_t posting_bytes = 0;
+    size_t forward_index_bytes = 0;
+    size_t document_column_bytes = 0;
+    IndexArenaStats arena;
+};
+
+// A document split into words, validated and counted, ready to be indexed.
+struct TokenizedDocument {
+    int id = 0;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    int rating = 0;
+    int word_count = 0;
+    // Distinct words in ascending order with their counts.
+    std::vector<std::pair<std::string, int>> word_counts;
+};
+
+// One element of the range passed to SearchServer::AddDocuments.
+struct DocumentInput {
+    int id = 0;
+    std::string_view text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+};
+
+class MappedSearchServer;
+
+// Matches documents of one status with a rating of at least min_rating. Unlike an arbitrary
+// predicate, the query path tests it for a whole block of slots at once in the SIMD kernel.
+struct DocumentStatusPredicate {
+    DocumentStatus status;
+    int min_rating = std::numeric_limits<int>::min();
+
+    bool operator()(int /*document_id*/, DocumentStatus document_status, int rating) const {
+        return document_status == status && rating >= min_rating;
+    }
+};
 
 class SearchServer {
 public:
     template <typename StringContainer>
-    explicit SearchServer(const StringContainer& stop_words);
-    explicit SearchServer(std::string_view stop_words_text);
-    explicit SearchServer(const std::string& stop_words_text);
+    explicit SearchServer(const StringContainer& stop_words, TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE,
+        IndexHugePages huge_pages = IndexHugePages::NONE);
+    explicit SearchServer(std::string_view stop_words_text, TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE,
+        IndexHugePages huge_pages = IndexHugePages::NONE);
+    explicit SearchServer(const std::string& stop_words_text, TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE,
+        IndexHugePages huge_pages = IndexHugePages::NONE);
+    // Loads a saved index back into memory, with its stop words and TermFreqStorage, to change it further.
+    explicit SearchServer(const MappedSearchServer& saved_index, IndexHugePages huge_pages = IndexHugePages::NONE);
 
     void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    // AddDocument in two steps. TokenizeDocument reads nothing but the stop words, so it may run on
+    // other threads while documents are being added; AddTokenizedDocument does the indexing.
+    // AddDocument and AddTokenizedDocument may be called from many threads at once, as long as
+    // nothing else uses the server meanwhile. Document ids stay unique.
+    TokenizedDocument TokenizeDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) const;
+    void AddTokenizedDocument(const TokenizedDocument& document);
+    // Adds every document of the range, or none if any of them is invalid. Chunks of the range are
+    // tokenized into partial indexes in parallel, which are then appended to this one in range order.
+    template <typename ExecutionPolicy, typename DocumentRange>
+    void AddDocuments(ExecutionPolicy&& policy, const DocumentRange& documents);
+    template <typename DocumentRange>
+    void AddDocuments(const DocumentRange& documents);
 
-    template <typename ExecutionPolicy, typename DocumentPredicate>
+    // Only the offset + limit best documents (after the cursor, if any) are ordered.
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, const PageRequest& page) const;
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status, const PageRequest& page) const;
+    // Weighs words by term_stats (see AddTermStats) instead of this index's own counts, so that
+    // the results of several indexes holding parts of one corpus can be merged by relevance.
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, const PageRequest& page,
+        const TermStats& term_stats) const;
+
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy, typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const;
     template <typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
 
-    template <typename ExecutionPolicy>
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const;
     std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
 
-    template <typename ExecutionPolicy>
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const;
     std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
 
+    // Same results as FindTopDocuments for every query, but each posting list is decoded and scored
+    // once per batch and added to all queries containing the word. The corpus is swept in slot tiles
+    // with each query's top documents carried over, so later tiles reject most documents in one compare.
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<std::vector<Document>> FindTopDocumentsBatch(ExecutionPolicy&& policy, const std::vector<std::string>& raw_queries, DocumentPredicate document_predicate) const;
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy>
+    std::vector<std::vector<Document>> FindTopDocumentsBatch(ExecutionPolicy&& policy, const std::vector<std::string>& raw_queries, DocumentStatus status) const;
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy>
+    std::vector<std::vector<Document>> FindTopDocumentsBatch(ExecutionPolicy&& policy, const std::vector<std::string>& raw_queries) const;
+
+    // Number of documents FindTopDocuments would match before truncation, without scoring or sorting.
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    int CountMatches(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const;
+    template <typename DocumentPredicate>
+    int CountMatches(std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    template <typename ExecutionPolicy>
+    int CountMatches(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const;
+    int CountMatches(std::string_view raw_query, DocumentStatus status) const;
+
+    template <typename ExecutionPolicy>
+    int CountMatches(ExecutionPolicy&& policy, std::string_view raw_query) const;
+    int CountMatches(std::string_view raw_query) const;
+
     int GetDocumentCount() const;
+    bool ContainsDocument(int document_id) const;
+
+    static bool IsRankedHigher(const Document& lhs, const Document& rhs);
+    CorpusStats GetCorpusStats() const;
+    // Adds this index's document count, word count and the document frequencies of the query's plus words.
+    void AddTermStats(std::string_view raw_query, TermStats& term_stats) const;
+    // Adds one document: its word count and every word it contains.
+    void AddDocumentTermStats(int document_id, TermStats& term_stats) const;
+    IndexMemoryStats GetIndexMemoryStats() const;
 
     std::set<int>::iterator begin();
     std::set<int>::iterator end();
 
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    std::map<std::string_view, double> GetWordFrequencies(int document_id) const;
 
     template <typename ExecutionPolicy>
     void RemoveDocument(ExecutionPolicy&& policy, int document_id);
@@ -54,75 +213,407 @@ public:
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(ExecutionPolicy&& policy, std::string_view raw_query, int document_id) const;
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
 
+    // Appends the documents of other, except skipped_document_ids, keeping their slot order and
+    // copying postings directly instead of re-tokenizing. Both indexes must use the same TermFreqStorage.
+    void AppendDocuments(const SearchServer& other, const std::set<int>& skipped_document_ids);
+
+    // Writes the index in the layout of index_format.h, to a temporary file that then replaces
+    // path, so a reader never maps a partly written index. Must not run concurrently with writers.
+    void Save(const std::string& path) const;
+    // Serves a saved index straight from the mapped file; see MappedSearchServer.
+    static MappedSearchServer OpenMapped(const std::string& path);
+
 private:
-    struct DocumentData {
-        int rating;
-        DocumentStatus status;
+    friend class MappedSearchServer;
+
+    // Postings of one word in ascending slot order. A slot is the dense index a
+    // document gets at ingest; it addresses DocumentColumns and the query accumulators.
+    // Only the frequency vector matching term_freq_storage_ is filled.
+    // Allocator-aware, so postings created inside the term stripes allocate from the index arena too.
+    struct PostingList {
+        using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+        explicit PostingList(const allocator_type& allocator = {})
+            : slots(allocator), term_freqs(allocator), float_term_freqs(allocator), word_counts(allocator) {
+        }
+
+        PostingList(const PostingList& other, const allocator_type& allocator)
+            : slots(other.slots, allocator), term_freqs(other.term_freqs, allocator)
+            , float_term_freqs(other.float_term_freqs, allocator), word_counts(other.word_counts, allocator) {
+        }
+
+        PostingList(PostingList&& other, const allocator_type& allocator)
+            : slots(std::move(other.slots), allocator), term_freqs(std::move(other.term_freqs), allocator)
+            , float_term_freqs(std::move(other.float_term_freqs), allocator), word_counts(std::move(other.word_counts), allocator) {
+        }
+
+        std::pmr::vector<uint32_t> slots;
+        std::pmr::vector<double> term_freqs;
+        std::pmr::vector<float> float_term_freqs;
+        std::pmr::vector<uint16_t> word_counts;
+    };
+
+    // words is the forward index, flattened: the sorted distinct words of slot s are
+    // words[word_offsets[s], word_offsets[s + 1]). A removed slot keeps its range until CompactSlots drops it.
+    struct DocumentColumns {
+        explicit DocumentColumns(std::pmr::memory_resource* resource)
+            : ids(resource), ratings(resource), statuses(resource), word_counts(resource), inv_word_counts(resource)
+            , word_offsets(1, 0, resource), words(resource) {
+        }
+
+        std::pmr::vector<int> ids;
+        std::pmr::vector<int> ratings;
+        std::pmr::vector<DocumentStatus> statuses;
+        std::pmr::vector<int> word_counts;
+        std::pmr::vector<double> inv_word_counts;
+        std::pmr::vector<size_t> word_offsets;
+        std::pmr::vector<std::string_view> words;
+    };
+
+    // What the query path reads of a posting list and of the document columns, as plain arrays,
+    // so that one query path serves both this index and a MappedSearchServer file. A posting
+    // view has only the frequency array of the index's TermFreqStorage set; a missing word has size 0.
+    struct PostingView {
+        const uint32_t* slots = nullptr;
+        const double* term_freqs = nullptr;
+        const float* float_term_freqs = nullptr;
+        const uint16_t* word_counts = nullptr;
+        size_t size = 0;
+    };
+
+    struct IndexView {
+        TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE;
+        size_t slot_count = 0;
+        const int* ids = nullptr;
+        const int* ratings = nullptr;
+        const DocumentStatus* statuses = nullptr;
+        const int* word_counts = nullptr;
+        const double* inv_word_counts = nullptr;
+    };
+
+    static constexpr size_t POSTING_BLOCK_SIZE = 4096;
+    static constexpr size_t DECODE_BLOCK_SIZE = 256;
+    // FindTopDocumentsBatch scores the corpus in slot tiles whose queries x slots
+    // accumulators stay cache resident (512 KiB).
+    static constexpr size_t BATCH_TILE_SCORES = size_t(1) << 16;
+    static constexpr size_t MIN_BATCH_TILE_SIZE = 1024;
+    // Smallest AddDocuments chunk worth a partial index of its own.
+    static constexpr size_t MIN_BULK_CHUNK_SIZE = 256;
+    // RemoveDocument compacts the slots once removed ones outnumber live ones and this many are dead.
+    static constexpr size_t MIN_COMPACTED_SLOT_COUNT = 1024;
+
+    const std::set<std::string, std::less<>> stop_words_;
+    const TermFreqStorage term_freq_storage_;
+    // The term dictionary is split by word hash into stripes with a lock each, so concurrent
+    // AddDocument calls only contend on words of the same stripe. A stripe interns its words
+    // and owns their posting lists.
+    struct TermStripe {
+        explicit TermStripe(std::pmr::memory_resource* resource) : words(resource), postings(resource) {
+        }
+
+        std::mutex mutex;
+        std::pmr::set<std::pmr::string, std::less<>> words;
+        std::pmr::map<std::string_view, PostingList, std::less<>> postings;
     };
-    const std::set<std::string> stop_words_;
-    std::set<std::string, std::less<>> words_to_server_;
-    std::map<std::string, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, DocumentData> documents_;
+
+    static constexpr size_t TERM_STRIPE_COUNT = 64;
+
+    // The term dictionary, postings, slot map and document columns all allocate from
+    // index_pool_, which keeps free lists for node-sized blocks and passes everything
+    // from IndexArena::MIN_BLOCK_SIZE up to the buddy slabs of index_arena_. The pool is
+    // synchronized because concurrent writers allocate from it under different locks.
+    IndexArena index_arena_;
+    std::pmr::synchronized_pool_resource index_pool_;
+    std::vector<std::unique_ptr<TermStripe>> term_stripes_;
+    // Guards the slot map, the document columns and the counters below while AddDocument
+    // runs on several threads.
+    std::mutex document_mutex_;
+    std::pmr::map<int, uint32_t> document_slots_;
+    DocumentColumns document_columns_;
     std::set<int> document_ids_;
-    std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
+    long long total_word_count_ = 0;
 
-    bool IsStopWord(const std::string& word) const;
-    static bool IsValidWord(const std::string& word);
+    bool IsStopWord(std::string_view word) const;
+    static bool IsValidWord(std::string_view word);
     std::vector<std::string> SplitIntoWordsNoStop(std::string_view text) const;
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
     struct QueryWord {
-        std::string data;
+        std::string_view data;
         bool is_minus;
         bool is_stop;
     };
 
-    QueryWord ParseQueryWord(const std::string& text) const;
+    static QueryWord ParseQueryWord(std::string_view text, const std::set<std::string, std::less<>>& stop_words);
+
+    using QueryWords = std::pmr::set<std::pmr::string>;
 
     struct Query {
-        std::set<std::string> plus_words;
-        std::set<std::string> minus_words;
+        explicit Query(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) : plus_words(resource), minus_words(resource) {
+        }
+
+        QueryWords plus_words;
+        QueryWords minus_words;
     };
 
     Query ParseQuery(std::string_view text) const;
-    double ComputeWordInverseDocumentFreq(const std::string& word) const;
+    // Splits into the given token buffer and allocates the word sets from resource.
+    Query ParseQuery(std::string_view text, std::vector<std::string>& tokens, std::pmr::memory_resource* resource) const;
+    static Query ParseQuery(std::string_view text, const std::set<std::string, std::less<>>& stop_words, std::vector<std::string>& tokens,
+        std::pmr::memory_resource* resource);
 
-    template <typename ExecutionPolicy, typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate) const;
+    template <typename Scorer, typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindPage(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, const PageRequest& page,
+        const TermStats* term_stats) const;
+    // The query path shared with MappedSearchServer. find_postings maps a word to its PostingView.
+    // Without term_stats, words are weighed by the index's own counts.
+    template <typename Scorer, typename ExecutionPolicy, typename PostingFinder, typename DocumentPredicate>
+    static std::vector<Document> FindPage(ExecutionPolicy&& policy, const IndexView& index, PostingFinder find_postings,
+        const std::set<std::string, std::less<>>& stop_words, std::string_view raw_query, DocumentPredicate document_predicate, const PageRequest& page,
+        const CorpusStats& corpus_stats, const TermStats* term_stats);
+    template <typename Scorer, typename ExecutionPolicy, typename PostingFinder, typename DocumentPredicate>
+    static std::vector<Document> FindAllDocuments(ExecutionPolicy&& policy, const IndexView& index, PostingFinder find_postings, const Query& query,
+        DocumentPredicate document_predicate, const PageRequest& page, const CorpusStats& corpus_stats, const TermStats* term_stats, WorkerScratch& scratch);
+
+    template <typename Scorer>
+    static void AccumulatePostings(const IndexView& index, const Scorer& scorer, double word_weight, const PostingView& postings, size_t begin, size_t end,
+        double* scores);
+    template <typename Scorer>
+    static void AccumulateTermFreqs(const IndexView& index, const Scorer& scorer, double word_weight, const uint32_t* slots, const double* term_freqs,
+        size_t count, double* scores);
+    static void DecodeTermFreqs(const IndexView& index, const PostingView& postings, size_t begin, size_t end, double* term_freqs);
+    double GetTermFreq(const PostingList& postings, size_t index) const;
+    template <typename PostingFinder>
+    static void ExcludeMinusWords(PostingFinder find_postings, const QueryWords& minus_words, double* scores);
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const;
+    static void CollectMatchedDocuments(const IndexView& index, const std::vector<double>& scores, DocumentPredicate document_predicate,
+        const PageRequest& page, std::vector<uint32_t>& matched_slots, std::vector<Document>& top_documents);
+    template <typename Scorer, typename DocumentPredicate>
+    void ScoreBatchRange(const Scorer& scorer, const std::vector<const PostingList*>& word_postings, const std::vector<std::vector<size_t>>& word_plus_queries,
+        const std::vector<std::vector<size_t>>& word_minus_queries, uint32_t begin_slot, uint32_t end_slot, size_t tile_size,
+        DocumentPredicate document_predicate, std::vector<std::vector<Document>>& top_documents) const;
+    static void PushTopDocument(std::vector<Document>& top_documents, const Document& document, size_t capacity);
+    static void OrderPage(std::vector<Document>& top_documents, const PageRequest& page);
+
+    // AddDocuments' merge step. Everything that allocates from the index runs serially; the
+    // postings and the forward index are then filled in parallel within the reserved capacity.
+    template <typename ExecutionPolicy>
+    void MergePartialIndexes(ExecutionPolicy&& policy, const std::vector<std::unique_ptr<SearchServer>>& partial_indexes);
 
-    template <typename Map>
-    void DeleteDocumentsFromMap(Map& map_container, const std::set<std::string>& minus_words) const;
+    TermStripe& GetTermStripe(std::string_view word) const;
+    // Expects the stripe to be locked or no concurrent writer.
+    static std::string_view InternWord(TermStripe& stripe, std::string_view word);
+    const PostingList* FindPostings(std::string_view word) const;
+    PostingView GetPostingView(std::string_view word) const;
+    IndexView GetIndexView() const;
+    void InsertPosting(PostingList& postings, uint32_t slot, int count, double inv_word_count) const;
 
+    IteratorRange<const std::string_view*> GetSlotWords(uint32_t slot) const;
+    static void EraseSlot(PostingList& postings, uint32_t slot);
+    // Drops the slots of removed documents from the columns, the forward index and the postings.
+    // Live slots keep their relative order, so every posting list stays sorted.
+    void CompactSlots();
 };
 
 
 template <typename StringContainer>
-SearchServer::SearchServer(const StringContainer& stop_words) : stop_words_(MakeUniqueNonEmptyStrings(stop_words)) {
+SearchServer::SearchServer(const StringContainer& stop_words, TermFreqStorage term_freq_storage, IndexHugePages huge_pages)
+    : stop_words_(MakeUniqueNonEmptyStrings(stop_words))
+    , term_freq_storage_(term_freq_storage)
+    , index_arena_(huge_pages)
+    , index_pool_(std::pmr::pool_options{ 0, IndexArena::MIN_BLOCK_SIZE }, &index_arena_)
+    , document_slots_(&index_pool_)
+    , document_columns_(&index_pool_) {
     if (!all_of(stop_words_.begin(), stop_words_.end(), IsValidWord)) {
         throw std::invalid_argument("Some of stop words are invalid"s);
     }
+    for (size_t i = 0; i < TERM_STRIPE_COUNT; ++i) {
+        term_stripes_.push_back(std::make_unique<TermStripe>(&index_pool_));
+    }
 }
 
-template <typename ExecutionPolicy, typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
-    const auto query = ParseQuery(raw_query);
+template <typename ExecutionPolicy, typename DocumentRange>
+void SearchServer::AddDocuments(ExecutionPolicy&& policy, const DocumentRange& documents) {
+    const size_t document_count = std::size(documents);
+    std::set<int> new_document_ids;
+    for (const DocumentInput& document : documents) {
+        if (document.id < 0 || document_slots_.count(document.id) > 0 || !new_document_ids.insert(document.id).second) {
+            throw std::invalid_argument("Invalid document_id");
+        }
+    }
 
-    auto matched_documents = FindAllDocuments(policy, query, document_predicate);
+    size_t chunk_count = 1;
+    if constexpr (IS_THREAD_POOL<ExecutionPolicy>) {
+        chunk_count = policy.GetThreadCount();
+    }
+    else if constexpr (!std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>) {
+        chunk_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    chunk_count = std::max<size_t>(1, std::min(chunk_count, document_count / MIN_BULK_CHUNK_SIZE));
 
-    sort(matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
-        if (std::abs(lhs.relevance - rhs.relevance) < 1e-6) {
-            return lhs.rating > rhs.rating;
+    // Parallel algorithms terminate on an escaping exception, so chunk errors are carried out by hand.
+    std::vector<std::unique_ptr<SearchServer>> partial_indexes(chunk_count);
+    std::vector<std::exception_ptr> chunk_errors(chunk_count);
+    std::vector<size_t> chunks(chunk_count);
+    std::iota(chunks.begin(), chunks.end(), 0);
+    ForEach(policy, chunks.begin(), chunks.end(), [&](size_t chunk) {
+        try {
+            auto partial_index = std::make_unique<SearchServer>(stop_words_, term_freq_storage_);
+            const auto end = std::next(std::begin(documents), document_count * (chunk + 1) / chunk_count);
+            for (auto it = std::next(std::begin(documents), document_count * chunk / chunk_count); it != end; ++it) {
+                partial_index->AddDocument(it->id, it->text, it->status, it->ratings);
+            }
+            partial_indexes[chunk] = std::move(partial_index);
         }
-        else {
-            return lhs.relevance > rhs.relevance;
+        catch (...) {
+            chunk_errors[chunk] = std::current_exception();
         }
         });
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+    for (const auto& error : chunk_errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
     }
-    return matched_documents;
+
+    MergePartialIndexes(policy, partial_indexes);
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::MergePartialIndexes(ExecutionPolicy&& policy, const std::vector<std::unique_ptr<SearchServer>>& partial_indexes) {
+    const size_t partial_count = partial_indexes.size();
+    std::vector<uint32_t> slot_offsets(partial_count + 1, static_cast<uint32_t>(document_columns_.ids.size()));
+    std::vector<size_t> word_offsets(partial_count + 1, document_columns_.words.size());
+    for (size_t i = 0; i < partial_count; ++i) {
+        slot_offsets[i + 1] = slot_offsets[i] + static_cast<uint32_t>(partial_indexes[i]->document_columns_.ids.size());
+        word_offsets[i + 1] = word_offsets[i] + partial_indexes[i]->document_columns_.words.size();
+    }
+
+    // A merge job fills one posting list of this index from the partial lists of the same word.
+    struct PostingMerge {
+        PostingList* postings;
+        std::vector<std::pair<size_t, const PostingList*>> sources;
+    };
+    std::vector<PostingMerge> posting_merges;
+    std::map<const PostingList*, size_t> merge_indices;
+    std::vector<std::unordered_map<const char*, std::string_view>> stored_words(partial_count);
+    for (size_t i = 0; i < partial_count; ++i) {
+        for (const auto& partial_stripe : partial_indexes[i]->term_stripes_) {
+            for (const auto& [partial_word, partial_postings] : partial_stripe->postings) {
+                TermStripe& stripe = GetTermStripe(partial_word);
+                const std::string_view stored_word = InternWord(stripe, partial_word);
+                stored_words[i].emplace(partial_word.data(), stored_word);
+                PostingList* postings = &stripe.postings[stored_word];
+                const auto [merge_it, inserted] = merge_indices.emplace(postings, posting_merges.size());
+                if (inserted) {
+                    posting_merges.push_back({ postings, {} });
+                }
+                posting_merges[merge_it->second].sources.emplace_back(i, &partial_postings);
+            }
+        }
+    }
+    for (PostingMerge& merge : posting_merges) {
+        size_t posting_count = merge.postings->slots.size();
+        for (const auto& [partial, partial_postings] : merge.sources) {
+            posting_count += partial_postings->slots.size();
+        }
+        merge.postings->slots.reserve(posting_count);
+        switch (term_freq_storage_) {
+        case TermFreqStorage::DOUBLE:
+            merge.postings->term_freqs.reserve(posting_count);
+            break;
+        case TermFreqStorage::FLOAT:
+            merge.postings->float_term_freqs.reserve(posting_count);
+            break;
+        case TermFreqStorage::COUNT:
+            merge.postings->word_counts.reserve(posting_count);
+            break;
+        }
+    }
+    document_columns_.words.resize(word_offsets.back());
+
+    ForEach(policy, posting_merges.begin(), posting_merges.end(), [this, &slot_offsets](PostingMerge& merge) {
+        PostingList& postings = *merge.postings;
+        for (const auto& [partial, partial_postings] : merge.sources) {
+            for (const uint32_t slot : partial_postings->slots) {
+                postings.slots.push_back(slot_offsets[partial] + slot);
+            }
+            postings.term_freqs.insert(postings.term_freqs.end(), partial_postings->term_freqs.begin(), partial_postings->term_freqs.end());
+            postings.float_term_freqs.insert(postings.float_term_freqs.end(), partial_postings->float_term_freqs.begin(), partial_postings->float_term_freqs.end());
+            postings.word_counts.insert(postings.word_counts.end(), partial_postings->word_counts.begin(), partial_postings->word_counts.end());
+        }
+        });
+    std::vector<size_t> partials(partial_count);
+    std::iota(partials.begin(), partials.end(), 0);
+    ForEach(policy, partials.begin(), partials.end(), [&](size_t i) {
+        const auto& partial_words = partial_indexes[i]->document_columns_.words;
+        std::transform(partial_words.begin(), partial_words.end(), document_columns_.words.begin() + word_offsets[i], [&](std::string_view word) {
+            return stored_words[i].find(word.data())->second;
+            });
+        });
+
+    for (size_t i = 0; i < partial_count; ++i) {
+        const DocumentColumns& partial_columns = partial_indexes[i]->document_columns_;
+        document_columns_.ids.insert(document_columns_.ids.end(), partial_columns.ids.begin(), partial_columns.ids.end());
+        document_columns_.ratings.insert(document_columns_.ratings.end(), partial_columns.ratings.begin(), partial_columns.ratings.end());
+        document_columns_.statuses.insert(document_columns_.statuses.end(), partial_columns.statuses.begin(), partial_columns.statuses.end());
+        document_columns_.word_counts.insert(document_columns_.word_counts.end(), partial_columns.word_counts.begin(), partial_columns.word_counts.end());
+        document_columns_.inv_word_counts.insert(document_columns_.inv_word_counts.end(), partial_columns.inv_word_counts.begin(), partial_columns.inv_word_counts.end());
+        for (size_t slot = 0; slot < partial_columns.ids.size(); ++slot) {
+            document_columns_.word_offsets.push_back(word_offsets[i] + partial_columns.word_offsets[slot + 1]);
+            document_slots_.emplace(partial_columns.ids[slot], slot_offsets[i] + static_cast<uint32_t>(slot));
+            document_ids_.insert(partial_columns.ids[slot]);
+        }
+        total_word_count_ += partial_indexes[i]->total_word_count_;
+    }
+}
+
+template <typename DocumentRange>
+void SearchServer::AddDocuments(const DocumentRange& documents) {
+    AddDocuments(std::execution::seq, documents);
+}
+
+inline bool SearchServer::IsRankedHigher(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) < RELEVANCE_EPSILON) {
+        if (lhs.rating != rhs.rating) {
+            return lhs.rating > rhs.rating;
+        }
+        return lhs.id < rhs.id;
+    }
+    return lhs.relevance > rhs.relevance;
+}
+
+// top_documents is a heap whose front is the lowest ranked of the kept documents.
+inline void SearchServer::PushTopDocument(std::vector<Document>& top_documents, const Document& document, size_t capacity) {
+    if (top_documents.size() < capacity) {
+        top_documents.push_back(document);
+        std::push_heap(top_documents.begin(), top_documents.end(), IsRankedHigher);
+    }
+    else if (capacity > 0 && IsRankedHigher(document, top_documents.front())) {
+        std::pop_heap(top_documents.begin(), top_documents.end(), IsRankedHigher);
+        top_documents.back() = document;
+        std::push_heap(top_documents.begin(), top_documents.end(), IsRankedHigher);
+    }
+}
+
+template <typename Scorer, typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, const PageRequest& page) const {
+    return FindPage<Scorer>(policy, raw_query, document_predicate, page, nullptr);
+}
+
+template <typename Scorer, typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, const PageRequest& page,
+    const TermStats& term_stats) const {
+    return FindPage<Scorer>(policy, raw_query, document_predicate, page, &term_stats);
+}
+
+template <typename Scorer, typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status, const PageRequest& page) const {
+    return SearchServer::FindTopDocuments<Scorer>(policy, raw_query, DocumentStatusPredicate{ status }, page);
+}
+
+template <typename Scorer, typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return SearchServer::FindTopDocuments<Scorer>(policy, raw_query, document_predicate, PageRequest{});
 }
 
 template <typename DocumentPredicate>
@@ -130,101 +621,412 @@ std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query,
     return SearchServer::FindTopDocuments(std::execution::seq, raw_query, document_predicate);
 }
 
-template <typename ExecutionPolicy>
+template <typename Scorer, typename ExecutionPolicy>
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const {
-    return SearchServer::FindTopDocuments(policy, raw_query, [&status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
-        });
+    return SearchServer::FindTopDocuments<Scorer>(policy, raw_query, DocumentStatusPredicate{ status });
 }
 
-template <typename ExecutionPolicy>
+template <typename Scorer, typename ExecutionPolicy>
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const {
-    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+    return FindTopDocuments<Scorer>(policy, raw_query, DocumentStatus::ACTUAL);
 }
 
-template <typename Map>
-void SearchServer::DeleteDocumentsFromMap(Map& map_container, const std::set<std::string>& minus_words) const {
-    for (const auto& minus_word : minus_words) {
-        if (word_to_document_freqs_.count(minus_word) == 0) {
-            continue;
+template <typename Scorer, typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<std::vector<Document>> SearchServer::FindTopDocumentsBatch(ExecutionPolicy&& policy, const std::vector<std::string>& raw_queries, DocumentPredicate document_predicate) const {
+    // Each query is parsed in its thread's arena, as in FindPage, and kept as the posting lists
+    // of its words, each flagged when the word is a minus word.
+    const size_t query_count = raw_queries.size();
+    std::vector<std::vector<std::pair<const PostingList*, bool>>> query_postings(query_count);
+    Transform(policy, raw_queries.begin(), raw_queries.end(), query_postings.begin(), [this](const std::string& raw_query) {
+        ScratchLease scratch;
+        std::vector<std::pair<const PostingList*, bool>> postings;
+        {
+            const auto query = ParseQuery(raw_query, scratch->tokens, scratch->arena.GetResource());
+            for (const auto& [words, is_minus] : { std::pair{ &query.plus_words, false }, std::pair{ &query.minus_words, true } }) {
+                for (const auto& word : *words) {
+                    if (const PostingList* word_postings = FindPostings(word)) {
+                        postings.emplace_back(word_postings, is_minus);
+                    }
+                }
+            }
+        }
+        scratch->arena.Reset();
+        return postings;
+        });
+
+    // The batch vocabulary: every indexed word once, with the queries that use it.
+    std::unordered_map<const PostingList*, size_t> word_indices;
+    std::vector<const PostingList*> word_postings;
+    std::vector<std::vector<size_t>> word_plus_queries;
+    std::vector<std::vector<size_t>> word_minus_queries;
+    for (size_t i = 0; i < query_count; ++i) {
+        for (const auto& [postings, is_minus] : query_postings[i]) {
+            const auto [index_it, inserted] = word_indices.emplace(postings, word_postings.size());
+            if (inserted) {
+                word_postings.push_back(postings);
+                word_plus_queries.emplace_back();
+                word_minus_queries.emplace_back();
+            }
+            (is_minus ? word_minus_queries : word_plus_queries)[index_it->second].push_back(i);
         }
-        for (const auto& [document_id, _] : word_to_document_freqs_.at(minus_word)) {
-            map_container.erase(document_id);
+    }
+
+    const Scorer scorer(GetCorpusStats());
+    const size_t slot_count = document_columns_.ids.size();
+    const size_t tile_size = std::max(MIN_BATCH_TILE_SIZE, BATCH_TILE_SCORES / std::max<size_t>(1, query_count));
+    const size_t tile_count = (slot_count + tile_size - 1) / tile_size;
+    // Each range is swept tile by tile, reusing its accumulators, heaps and posting cursors.
+    const size_t range_count = std::min<size_t>(tile_count, 4 * std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<size_t> ranges(range_count);
+    std::iota(ranges.begin(), ranges.end(), 0);
+
+    std::vector<std::vector<std::vector<Document>>> range_results(range_count, std::vector<std::vector<Document>>(query_count));
+    ForEach(policy, ranges.begin(), ranges.end(), [&](size_t range) {
+        const uint32_t begin_slot = static_cast<uint32_t>(tile_count * range / range_count * tile_size);
+        const uint32_t end_slot = static_cast<uint32_t>(std::min(tile_count * (range + 1) / range_count * tile_size, slot_count));
+        ScoreBatchRange(scorer, word_postings, word_plus_queries, word_minus_queries, begin_slot, end_slot, tile_size, document_predicate, range_results[range]);
+        });
+
+    const PageRequest page;
+    std::vector<std::vector<Document>> results(query_count);
+    for (size_t i = 0; i < query_count; ++i) {
+        for (const auto& range_documents : range_results) {
+            for (const Document& document : range_documents[i]) {
+                PushTopDocument(results[i], document, page.GetEnd());
+            }
         }
+        OrderPage(results[i], page);
     }
+    return results;
 }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const {
+template <typename Scorer, typename ExecutionPolicy>
+std::vector<std::vector<Document>> SearchServer::FindTopDocumentsBatch(ExecutionPolicy&& policy, const std::vector<std::string>& raw_queries, DocumentStatus status) const {
+    return FindTopDocumentsBatch<Scorer>(policy, raw_queries, DocumentStatusPredicate{ status });
+}
+
+template <typename Scorer, typename ExecutionPolicy>
+std::vector<std::vector<Document>> SearchServer::FindTopDocumentsBatch(ExecutionPolicy&& policy, const std::vector<std::string>& raw_queries) const {
+    return FindTopDocumentsBatch<Scorer>(policy, raw_queries, DocumentStatus::ACTUAL);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+int SearchServer::CountMatches(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
+    const auto query = ParseQuery(raw_query);
+
+    // A slot is visited once: minus words mark it up front, plus words mark it when first seen.
+    std::vector<char> visited(document_columns_.ids.size(), 0);
+    for (const auto& word : query.minus_words) {
+        const PostingList* postings = FindPostings(word);
+        if (postings == nullptr) {
+            continue;
+        }
+        for (const uint32_t slot : postings->slots) {
+            visited[slot] = 1;
+        }
+    }
 
-    std::map<int, double> document_to_relevance;
-    for (const std::string& word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+    std::vector<uint32_t> candidate_slots;
+    for (const auto& word : query.plus_words) {
+        const PostingList* postings = FindPostings(word);
+        if (postings == nullptr) {
             continue;
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-            const auto& document_data = documents_.at(document_id);
-            if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
+        for (const uint32_t slot : postings->slots) {
+            if (!visited[slot]) {
+                visited[slot] = 1;
+                candidate_slots.push_back(slot);
             }
         }
     }
 
-    DeleteDocumentsFromMap(document_to_relevance, query.minus_words);
+    return static_cast<int>(CountIf(policy, candidate_slots.begin(), candidate_slots.end(), [this, &document_predicate](uint32_t slot) {
+        return document_predicate(document_columns_.ids[slot], document_columns_.statuses[slot], document_columns_.ratings[slot]);
+        }));
+}
+
+template <typename DocumentPredicate>
+int SearchServer::CountMatches(std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return CountMatches(std::execution::seq, raw_query, document_predicate);
+}
+
+template <typename ExecutionPolicy>
+int SearchServer::CountMatches(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const {
+    return CountMatches(policy, raw_query, DocumentStatusPredicate{ status });
+}
+
+template <typename ExecutionPolicy>
+int SearchServer::CountMatches(ExecutionPolicy&& policy, std::string_view raw_query) const {
+    return CountMatches(policy, raw_query, DocumentStatus::ACTUAL);
+}
 
+template <typename Scorer, typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindPage(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, const PageRequest& page,
+    const TermStats* term_stats) const {
+    const CorpusStats corpus_stats = term_stats != nullptr ? term_stats->GetCorpusStats() : GetCorpusStats();
+    return FindPage<Scorer>(policy, GetIndexView(), [this](std::string_view word) {
+        return GetPostingView(word);
+        }, stop_words_, raw_query, document_predicate, page, corpus_stats, term_stats);
+}
+
+template <typename Scorer, typename ExecutionPolicy, typename PostingFinder, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindPage(ExecutionPolicy&& policy, const IndexView& index, PostingFinder find_postings,
+    const std::set<std::string, std::less<>>& stop_words, std::string_view raw_query, DocumentPredicate document_predicate, const PageRequest& page,
+    const CorpusStats& corpus_stats, const TermStats* term_stats) {
+    // The query and its temporaries live in the thread's arena, dropped as a whole afterwards.
+    ScratchLease scratch;
     std::vector<Document> matched_documents;
-    for (const auto& [document_id, relevance] : document_to_relevance) {
-        matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+    {
+        const auto query = ParseQuery(raw_query, stop_words, scratch->tokens, scratch->arena.GetResource());
+        matched_documents = FindAllDocuments<Scorer>(policy, index, find_postings, query, document_predicate, page, corpus_stats, term_stats, *scratch);
     }
+    scratch->arena.Reset();
+    OrderPage(matched_documents, page);
     return matched_documents;
-
 }
 
-template <typename ExecutionPolicy, typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate) const {
+template <typename Scorer, typename ExecutionPolicy, typename PostingFinder, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindAllDocuments(ExecutionPolicy&& policy, const IndexView& index, PostingFinder find_postings, const Query& query,
+    DocumentPredicate document_predicate, const PageRequest& page, const CorpusStats& corpus_stats, const TermStats* term_stats, WorkerScratch& scratch) {
 
-    ConcurrentMap<int, double> document_to_relevance_conc(3);
-    for (const std::string& word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+    const Scorer scorer(corpus_stats);
+    std::vector<double>& scores = scratch.scores;
+    scores.assign(index.slot_count, UNMATCHED_SCORE);
+    for (const auto& word : query.plus_words) {
+        const PostingView postings = find_postings(word);
+        const size_t posting_count = postings.size;
+        if (posting_count == 0) {
             continue;
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto& [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-            const auto& document_data = documents_.at(document_id);
-            if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                document_to_relevance_conc[document_id].ref_to_value += term_freq * inverse_document_freq;
+        int document_freq = static_cast<int>(posting_count);
+        if (term_stats != nullptr) {
+            // term_stats may come off the wire, so a missing count is the caller's error. A count of
+            // 0 means every posting here belongs to a document removed elsewhere, as in a sealed segment.
+            const auto freq_it = term_stats->document_freqs.find(std::string_view(word));
+            if (freq_it == term_stats->document_freqs.end()) {
+                throw std::invalid_argument("No document frequency for query word "s + std::string(word));
             }
+            if (freq_it->second <= 0) {
+                continue;
+            }
+            document_freq = freq_it->second;
         }
+        const double word_weight = scorer.ComputeWordWeight(document_freq);
+
+        // Slots are unique within a posting list, so its blocks never touch the same accumulator.
+        std::pmr::vector<size_t> block_begins((posting_count + POSTING_BLOCK_SIZE - 1) / POSTING_BLOCK_SIZE, scratch.arena.GetResource());
+        std::iota(block_begins.begin(), block_begins.end(), 0);
+        ForEach(policy, block_begins.begin(), block_begins.end(), [&](size_t block) {
+            const size_t begin = block * POSTING_BLOCK_SIZE;
+            AccumulatePostings(index, scorer, word_weight, postings, begin, std::min(begin + POSTING_BLOCK_SIZE, posting_count), scores.data());
+            });
     }
 
-    DeleteDocumentsFromMap(document_to_relevance_conc, query.minus_words);
+    ExcludeMinusWords(find_postings, query.minus_words, scores.data());
 
     std::vector<Document> matched_documents;
-    
-    for (const auto& [document_id, relevance] : document_to_relevance_conc.BuildOrdinaryMap()) {
-        matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
-    }
+    CollectMatchedDocuments(index, scores, document_predicate, page, scratch.slots, matched_documents);
     return matched_documents;
 }
 
+template <typename Scorer>
+void SearchServer::AccumulatePostings(const IndexView& index, const Scorer& scorer, double word_weight, const PostingView& postings, size_t begin, size_t end,
+    double* scores) {
+    if (index.term_freq_storage == TermFreqStorage::DOUBLE) {
+        AccumulateTermFreqs(index, scorer, word_weight, postings.slots + begin, postings.term_freqs + begin, end - begin, scores);
+        return;
+    }
+    double term_freqs[DECODE_BLOCK_SIZE];
+    for (size_t chunk_begin = begin; chunk_begin < end; chunk_begin += DECODE_BLOCK_SIZE) {
+        const size_t chunk_end = std::min(chunk_begin + DECODE_BLOCK_SIZE, end);
+        DecodeTermFreqs(index, postings, chunk_begin, chunk_end, term_freqs);
+        AccumulateTermFreqs(index, scorer, word_weight, postings.slots + chunk_begin, term_freqs, chunk_end - chunk_begin, scores);
+    }
+}
+
+template <typename Scorer>
+void SearchServer::AccumulateTermFreqs(const IndexView& index, const Scorer& scorer, double word_weight, const uint32_t* slots, const double* term_freqs,
+    size_t count, double* scores) {
+    if constexpr (Scorer::LINEAR_IN_TERM_FREQ) {
+        AccumulateScores(slots, term_freqs, count, word_weight, scores);
+    }
+    else {
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t slot = slots[i];
+            scores[slot] += scorer.ComputeScore(word_weight, term_freqs[i], index.word_counts[slot]);
+        }
+    }
+}
+
+template <typename PostingFinder>
+void SearchServer::ExcludeMinusWords(PostingFinder find_postings, const QueryWords& minus_words, double* scores) {
+    for (const auto& word : minus_words) {
+        const PostingView postings = find_postings(word);
+        for (size_t i = 0; i < postings.size; ++i) {
+            scores[postings.slots[i]] = UNMATCHED_SCORE;
+        }
+    }
+}
+
+template <typename DocumentPredicate>
+void SearchServer::CollectMatchedDocuments(const IndexView& index, const std::vector<double>& scores, DocumentPredicate document_predicate,
+    const PageRequest& page, std::vector<uint32_t>& matched_slots, std::vector<Document>& top_documents) {
+    matched_slots.clear();
+    if constexpr (std::is_same_v<DocumentPredicate, DocumentStatusPredicate>) {
+        SelectMatchedSlots(scores.data(), index.statuses, index.ratings, scores.size(), document_predicate.status, document_predicate.min_rating,
+            matched_slots);
+    }
+    else {
+        SelectMatchedSlots(scores.data(), scores.size(), matched_slots);
+    }
+
+    std::optional<Document> cursor_document;
+    if (page.search_after) {
+        cursor_document.emplace(page.search_after->id, page.search_after->relevance, page.search_after->rating);
+    }
+    const size_t capacity = page.GetEnd();
+    top_documents.reserve(std::min(capacity, matched_slots.size()));
+    for (const uint32_t slot : matched_slots) {
+        const Document document(index.ids[slot], scores[slot], index.ratings[slot]);
+        if (cursor_document && !IsRankedHigher(*cursor_document, document)) {
+            continue;
+        }
+        if (document_predicate(document.id, index.statuses[slot], document.rating)) {
+            PushTopDocument(top_documents, document, capacity);
+        }
+    }
+}
+
+// Accumulators are query-major within a tile. Each word's postings in the tile are rebased and
+// decoded (or scored) once, then every query using the word adds them with the SIMD kernel.
+template <typename Scorer, typename DocumentPredicate>
+void SearchServer::ScoreBatchRange(const Scorer& scorer, const std::vector<const PostingList*>& word_postings, const std::vector<std::vector<size_t>>& word_plus_queries,
+    const std::vector<std::vector<size_t>>& word_minus_queries, uint32_t begin_slot, uint32_t end_slot, size_t tile_size,
+    DocumentPredicate document_predicate, std::vector<std::vector<Document>>& top_documents) const {
+
+    const IndexView index = GetIndexView();
+    const size_t query_count = top_documents.size();
+    const size_t word_count = word_postings.size();
+    std::vector<double> word_weights(word_count);
+    std::vector<size_t> tile_begins(word_count);
+    std::vector<size_t> tile_ends(word_count);
+    for (size_t word = 0; word < word_count; ++word) {
+        const auto& slots = word_postings[word]->slots;
+        word_weights[word] = scorer.ComputeWordWeight(static_cast<int>(slots.size()));
+        tile_ends[word] = std::lower_bound(slots.begin(), slots.end(), begin_slot) - slots.begin();
+    }
+
+    std::vector<double> scores;
+    std::vector<uint32_t> tile_slots;
+    std::vector<double> posting_values;
+    const size_t capacity = MAX_RESULT_DOCUMENT_COUNT;
+    for (uint32_t first_slot = begin_slot; first_slot < end_slot; first_slot += static_cast<uint32_t>(tile_size)) {
+        const uint32_t last_slot = static_cast<uint32_t>(std::min<size_t>(first_slot + tile_size, end_slot));
+        const size_t tile_slot_count = last_slot - first_slot;
+        scores.assign(query_count * tile_slot_count, UNMATCHED_SCORE);
+
+        for (size_t word = 0; word < word_count; ++word) {
+            const PostingList& postings = *word_postings[word];
+            const size_t begin = tile_begins[word] = tile_ends[word];
+            const size_t end = tile_ends[word] = std::lower_bound(postings.slots.begin() + begin, postings.slots.end(), last_slot) - postings.slots.begin();
+            const auto& plus_queries = word_plus_queries[word];
+            if (plus_queries.empty() || begin == end) {
+                continue;
+            }
+            const size_t count = end - begin;
+            tile_slots.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                tile_slots[i] = postings.slots[begin + i] - first_slot;
+            }
+            posting_values.resize(count);
+            const double* values = postings.term_freqs.data() + begin;
+            if (term_freq_storage_ != TermFreqStorage::DOUBLE) {
+                const PostingView view{ postings.slots.data(), postings.term_freqs.data(), postings.float_term_freqs.data(), postings.word_counts.data(),
+                    postings.slots.size() };
+                DecodeTermFreqs(index, view, begin, end, posting_values.data());
+                values = posting_values.data();
+            }
+            // A non-linear score is computed once here and added with a weight of 1, which is exact.
+            double weight = word_weights[word];
+            if constexpr (!Scorer::LINEAR_IN_TERM_FREQ) {
+                for (size_t i = 0; i < count; ++i) {
+                    posting_values[i] = scorer.ComputeScore(weight, values[i], index.word_counts[postings.slots[begin + i]]);
+                }
+                values = posting_values.data();
+                weight = 1.0;
+            }
+            for (const size_t i : plus_queries) {
+                AccumulateScores(tile_slots.data(), values, count, weight, scores.data() + i * tile_slot_count);
+            }
+        }
+        // Minus words go last: a later plus word would otherwise lift an excluded score off -0.0.
+        for (size_t word = 0; word < word_count; ++word) {
+            const auto& slots = word_postings[word]->slots;
+            for (const size_t i : word_minus_queries[word]) {
+                double* query_scores = scores.data() + i * tile_slot_count;
+                for (size_t posting = tile_begins[word]; posting < tile_ends[word]; ++posting) {
+                    query_scores[slots[posting] - first_slot] = UNMATCHED_SCORE;
+                }
+            }
+        }
 
+        // The heaps carry over from earlier tiles, so once one is full a score below its lowest
+        // is dropped by a single compare, before the document is even built.
+        for (size_t i = 0; i < query_count; ++i) {
+            const double* query_scores = scores.data() + i * tile_slot_count;
+            std::vector<Document>& query_documents = top_documents[i];
+            const auto get_min_relevance = [&query_documents, capacity] {
+                return query_documents.size() < capacity ? -std::numeric_limits<double>::infinity() : query_documents.front().relevance - RELEVANCE_EPSILON;
+            };
+            double min_relevance = get_min_relevance();
+            for (size_t offset = 0; offset < tile_slot_count; ++offset) {
+                const double score = query_scores[offset];
+                if (score <= min_relevance || std::signbit(score)) {
+                    continue;
+                }
+                const uint32_t slot = first_slot + static_cast<uint32_t>(offset);
+                if (document_predicate(index.ids[slot], index.statuses[slot], index.ratings[slot])) {
+                    PushTopDocument(query_documents, Document(index.ids[slot], score, index.ratings[slot]), capacity);
+                    min_relevance = get_min_relevance();
+                }
+            }
+        }
+    }
+}
 
 template <typename ExecutionPolicy>
 void SearchServer::RemoveDocument(ExecutionPolicy&& policy, int document_id) {
-    if (document_ids_.count(document_id) == 0) {
+    const auto slot_it = document_slots_.find(document_id);
+    if (slot_it == document_slots_.end()) {
         return;
     }
-    std::for_each(word_to_document_freqs_.begin(), word_to_document_freqs_.end(), [&document_id](auto& map_element) {
+    const uint32_t slot = slot_it->second;
+    const auto document_words = GetSlotWords(slot);
 
-        if (map_element.second.count(document_id) == 0) {
-            return;
-        }
-        map_element.second.erase(document_id);
+    std::vector<PostingList*> postings_to_update;
+    postings_to_update.reserve(document_words.size());
+    for (const std::string_view word : document_words) {
+        postings_to_update.push_back(&GetTermStripe(word).postings.find(word)->second);
+    }
+    ForEach(policy, postings_to_update.begin(), postings_to_update.end(), [slot](PostingList* postings) {
+        EraseSlot(*postings, slot);
         });
+    for (const std::string_view word : document_words) {
+        auto& stripe_postings = GetTermStripe(word).postings;
+        const auto postings_it = stripe_postings.find(word);
+        if (postings_it->second.slots.empty()) {
+            stripe_postings.erase(postings_it);
+        }
+    }
+
+    total_word_count_ -= document_columns_.word_counts[slot];
     document_ids_.erase(document_id);
-    documents_.erase(document_id);
-    document_to_word_freqs_.erase(document_id);
+    document_slots_.erase(slot_it);
+
+    const size_t removed_slot_count = document_columns_.ids.size() - document_slots_.size();
+    if (removed_slot_count >= MIN_COMPACTED_SLOT_COUNT && removed_slot_count > document_slots_.size()) {
+        CompactSlots();
+    }
 }
 
 template <typename ExecutionPolicy>
@@ -235,33 +1037,24 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
     }
 
     const auto query = ParseQuery(raw_query);
+    const uint32_t slot = document_slots_.at(document_id);
+    const auto document_words = GetSlotWords(slot);
+    const DocumentStatus status = document_columns_.statuses[slot];
 
-    std::vector<std::string_view> matched_words;
-
-    std::for_each(query.plus_words.begin(), query.plus_words.end(), [&matched_words, this, &document_id](const std::string& word) {
-
-        if (word_to_document_freqs_.count(word) == 0) {
-            return;
-        }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            matched_words.push_back(*(words_to_server_.find(word)));
-        }
-
+    const bool has_minus_word = std::any_of(query.minus_words.begin(), query.minus_words.end(), [&document_words](const auto& word) {
+        return std::binary_search(document_words.begin(), document_words.end(), std::string_view(word));
         });
+    if (has_minus_word) {
+        return { std::vector<std::string_view>{}, status };
+    }
 
-    const auto breaking_word = std::find_if(query.minus_words.begin(), query.minus_words.end(), [this, &document_id](const std::string& word) {
-        if (!word_to_document_freqs_.count(word)) {
-            return false;
-        }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            return true;
+    std::vector<std::string_view> matched_words;
+    for (const auto& word : query.plus_words) {
+        const auto word_it = std::lower_bound(document_words.begin(), document_words.end(), std::string_view(word));
+        if (word_it != document_words.end() && *word_it == word) {
+            matched_words.push_back(*word_it);
         }
-        return false;
-        });
-
-    if (breaking_word != query.minus_words.end()) {
-        matched_words.clear();
     }
 
-    return { matched_words, documents_.at(document_id).status };
+    return { matched_words, status };
 }
\ No newline at end of file
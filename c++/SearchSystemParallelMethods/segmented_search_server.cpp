@@ -0,0 +1,212 @@
+#include "segmented_search_server.h"
+
+SegmentedSearchServer::SegmentedSearchServer(std::string_view stop_words_text, SegmentMergePolicy merge_policy, TermFreqStorage term_freq_storage)
+    : SegmentedSearchServer(SplitIntoWords(stop_words_text), merge_policy, term_freq_storage) {
+}
+
+SegmentedSearchServer::SegmentedSearchServer(const std::string& stop_words_text, SegmentMergePolicy merge_policy, TermFreqStorage term_freq_storage)
+    : SegmentedSearchServer(SplitIntoWords(stop_words_text), merge_policy, term_freq_storage) {
+}
+
+SegmentedSearchServer::~SegmentedSearchServer() {
+    {
+        std::unique_lock lock(mutex_);
+        stopping_ = true;
+    }
+    merge_wanted_.notify_all();
+    merge_thread_.join();
+}
+
+void SegmentedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    const TokenizedDocument tokenized_document = tokenizer_.TokenizeDocument(document_id, document, status, ratings);
+    std::unique_lock lock(mutex_);
+    if (document_ids_.count(document_id) > 0) {
+        throw std::invalid_argument("Invalid document_id");
+    }
+    buffer_->AddTokenizedDocument(tokenized_document);
+    document_ids_.insert(document_id);
+    if (static_cast<size_t>(buffer_->GetDocumentCount()) >= merge_policy_.buffer_document_count) {
+        Seal();
+    }
+}
+
+void SegmentedSearchServer::RemoveDocument(int document_id) {
+    std::unique_lock lock(mutex_);
+    if (document_ids_.erase(document_id) == 0) {
+        return;
+    }
+    if (buffer_->ContainsDocument(document_id)) {
+        buffer_->RemoveDocument(document_id);
+        return;
+    }
+    // A removed id may have been added again later, so the live copy is in the newest segment holding it.
+    for (auto segment_it = segments_.rbegin(); segment_it != segments_.rend(); ++segment_it) {
+        if (segment_it->index->ContainsDocument(document_id) && segment_it->tombstones.count(document_id) == 0) {
+            TermStats& document_stats = segment_it->tombstones[document_id];
+            segment_it->index->AddDocumentTermStats(document_id, document_stats);
+            tombstone_stats_.document_count += document_stats.document_count;
+            tombstone_stats_.total_word_count += document_stats.total_word_count;
+            for (const auto& [word, document_freq] : document_stats.document_freqs) {
+                tombstone_stats_.document_freqs[word] += document_freq;
+            }
+            return;
+        }
+    }
+}
+
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(std::execution::seq, raw_query);
+}
+
+int SegmentedSearchServer::GetDocumentCount() const {
+    std::shared_lock lock(mutex_);
+    return static_cast<int>(document_ids_.size());
+}
+
+std::vector<int> SegmentedSearchServer::GetSegmentSizes() const {
+    std::shared_lock lock(mutex_);
+    std::vector<int> sizes;
+    for (const Segment& segment : segments_) {
+        sizes.push_back(segment.index->GetDocumentCount());
+    }
+    sizes.push_back(buffer_->GetDocumentCount());
+    return sizes;
+}
+
+void SegmentedSearchServer::WaitForMerges() {
+    std::unique_lock lock(mutex_);
+    merges_idle_.wait(lock, [this] {
+        return !merge_running_ && PickMergeInputs().empty();
+        });
+}
+
+void SegmentedSearchServer::Seal() {
+    segments_.push_back({ std::move(buffer_), {}, false });
+    buffer_ = std::make_unique<SearchServer>(stop_words_, term_freq_storage_);
+    merge_wanted_.notify_one();
+}
+
+TermStats SegmentedSearchServer::GetTermStats(std::string_view raw_query) const {
+    TermStats term_stats;
+    for (const Segment& segment : segments_) {
+        segment.index->AddTermStats(raw_query, term_stats);
+    }
+    buffer_->AddTermStats(raw_query, term_stats);
+    term_stats.document_count -= tombstone_stats_.document_count;
+    term_stats.total_word_count -= tombstone_stats_.total_word_count;
+    for (auto& [word, document_freq] : term_stats.document_freqs) {
+        const auto tombstone_it = tombstone_stats_.document_freqs.find(word);
+        if (tombstone_it != tombstone_stats_.document_freqs.end()) {
+            document_freq -= tombstone_it->second;
+        }
+    }
+    return term_stats;
+}
+
+size_t SegmentedSearchServer::GetTier(const SearchServer& index) const {
+    size_t tier = 0;
+    for (size_t bound = merge_policy_.buffer_document_count * merge_policy_.merge_factor;
+        static_cast<size_t>(index.GetDocumentCount()) >= bound; bound *= merge_policy_.merge_factor) {
+        ++tier;
+    }
+    return tier;
+}
+
+// The oldest merge_factor segments of the lowest tier that has that many, or nothing.
+std::vector<size_t> SegmentedSearchServer::PickMergeInputs() const {
+    std::map<size_t, std::vector<size_t>> tiers;
+    for (size_t i = 0; i < segments_.size(); ++i) {
+        if (!segments_[i].merging) {
+            tiers[GetTier(*segments_[i].index)].push_back(i);
+        }
+    }
+    for (auto& [tier, segment_indices] : tiers) {
+        if (segment_indices.size() >= merge_policy_.merge_factor) {
+            segment_indices.resize(merge_policy_.merge_factor);
+            return segment_indices;
+        }
+    }
+    return {};
+}
+
+void SegmentedSearchServer::RunMerges() {
+    std::unique_lock lock(mutex_);
+    while (true) {
+        const std::vector<size_t> input_indices = PickMergeInputs();
+        if (input_indices.empty()) {
+            merges_idle_.notify_all();
+            if (stopping_) {
+                return;
+            }
+            merge_wanted_.wait(lock);
+            continue;
+        }
+
+        std::vector<std::shared_ptr<const SearchServer>> inputs;
+        std::vector<std::set<int>> dropped_document_ids;
+        for (const size_t i : input_indices) {
+            segments_[i].merging = true;
+            inputs.push_back(segments_[i].index);
+            dropped_document_ids.emplace_back();
+            for (const auto& [document_id, document_stats] : segments_[i].tombstones) {
+                dropped_document_ids.back().insert(document_id);
+            }
+        }
+        merge_running_ = true;
+
+        // Sealed segments are immutable, so they are read without the lock while queries go on.
+        lock.unlock();
+        auto merged = std::make_shared<SearchServer>(stop_words_, term_freq_storage_);
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            merged->AppendDocuments(*inputs[i], dropped_document_ids[i]);
+        }
+        lock.lock();
+
+        std::vector<const SearchServer*> input_pointers;
+        for (const auto& input : inputs) {
+            input_pointers.push_back(input.get());
+        }
+        InstallMerge(input_pointers, dropped_document_ids, std::move(merged));
+        merge_running_ = false;
+        if (stopping_) {
+            merges_idle_.notify_all();
+            return;
+        }
+    }
+}
+
+// Tombstones of documents the merge dropped are retired; the ones recorded while it ran move to the merged segment.
+void SegmentedSearchServer::InstallMerge(const std::vector<const SearchServer*>& inputs, const std::vector<std::set<int>>& dropped_document_ids,
+    std::shared_ptr<const SearchServer> merged) {
+    Segment merged_segment{ std::move(merged), {}, false };
+    size_t merged_position = segments_.size();
+    std::vector<Segment> remaining_segments;
+    for (Segment& segment : segments_) {
+        const auto input_it = std::find(inputs.begin(), inputs.end(), segment.index.get());
+        if (input_it == inputs.end()) {
+            remaining_segments.push_back(std::move(segment));
+            continue;
+        }
+        merged_position = std::min(merged_position, remaining_segments.size());
+        const std::set<int>& dropped = dropped_document_ids[input_it - inputs.begin()];
+        for (auto& [document_id, document_stats] : segment.tombstones) {
+            if (dropped.count(document_id) == 0) {
+                merged_segment.tombstones.emplace(document_id, std::move(document_stats));
+                continue;
+            }
+            tombstone_stats_.document_count -= document_stats.document_count;
+            tombstone_stats_.total_word_count -= document_stats.total_word_count;
+            for (const auto& [word, document_freq] : document_stats.document_freqs) {
+                const auto tombstone_it = tombstone_stats_.document_freqs.find(word);
+                tombstone_it->second -= document_freq;
+                if (tombstone_it->second == 0) {
+                    tombstone_stats_.document_freqs.erase(tombstone_it);
+                }
+            }
+        }
+    }
+    if (merged_segment.index->GetDocumentCount() > 0) {
+        remaining_segments.insert(remaining_segments.begin() + merged_position, std::move(merged_segment));
+    }
+    segments_ = std::move(remaining_segments);
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "search_server.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+struct SegmentMergePolicy {
+    // Documents the mutable segment takes before it is sealed.
+    size_t buffer_document_count = 4096;
+    // How many segments of one size tier are merged into one.
+    size_t merge_factor = 4;
+};
+
+// Log-structured index. AddDocument only touches a small mutable segment, which is sealed
+// into an immutable one when full; a background thread merges every merge_factor sealed
+// segments of a size tier into one, so the segment count stays logarithmic and ingest never
+// waits for a large index to grow. Removing a document from a sealed segment records a
+// tombstone that the next merge of the segment drops. Queries search all segments with the
+// corpus-wide word statistics, so they rank like one SearchServer holding the same documents.
+// Queries may run concurrently with each other and with writes.
+class SegmentedSearchServer {
+public:
+    template <typename StringContainer>
+    explicit SegmentedSearchServer(const StringContainer& stop_words, SegmentMergePolicy merge_policy = {},
+        TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE);
+    explicit SegmentedSearchServer(std::string_view stop_words_text, SegmentMergePolicy merge_policy = {},
+        TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE);
+    explicit SegmentedSearchServer(const std::string& stop_words_text, SegmentMergePolicy merge_policy = {},
+        TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE);
+    ~SegmentedSearchServer();
+    SegmentedSearchServer(const SegmentedSearchServer&) = delete;
+    SegmentedSearchServer& operator=(const SegmentedSearchServer&) = delete;
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    void RemoveDocument(int document_id);
+
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, const PageRequest& page) const;
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const;
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    int GetDocumentCount() const;
+    // Document counts of the sealed segments, tombstoned documents included, then of the mutable one.
+    std::vector<int> GetSegmentSizes() const;
+    // Blocks until the background thread has no merge to do.
+    void WaitForMerges();
+
+private:
+    struct Segment {
+        std::shared_ptr<const SearchServer> index;
+        // Removed documents still in index, with what they add to the corpus statistics.
+        std::map<int, TermStats> tombstones;
+        bool merging = false;
+    };
+
+    void Seal();
+    TermStats GetTermStats(std::string_view raw_query) const;
+    size_t GetTier(const SearchServer& index) const;
+    std::vector<size_t> PickMergeInputs() const;
+    void RunMerges();
+    void InstallMerge(const std::vector<const SearchServer*>& inputs, const std::vector<std::set<int>>& dropped_document_ids,
+        std::shared_ptr<const SearchServer> merged);
+
+    const std::vector<std::string> stop_words_;
+    const SegmentMergePolicy merge_policy_;
+    const TermFreqStorage term_freq_storage_;
+    // Holds no documents. buffer_ is replaced on Seal, so AddDocument tokenizes with this one, outside the lock.
+    const SearchServer tokenizer_;
+
+    mutable std::shared_mutex mutex_;
+    std::condition_variable_any merge_wanted_;
+    std::condition_variable_any merges_idle_;
+    std::unique_ptr<SearchServer> buffer_;
+    std::vector<Segment> segments_;
+    std::set<int> document_ids_;
+    // Sum of the tombstones of all segments, subtracted from every query's statistics.
+    TermStats tombstone_stats_;
+    bool merge_running_ = false;
+    bool stopping_ = false;
+    std::thread merge_thread_;
+};
+
+template <typename StringContainer>
+SegmentedSearchServer::SegmentedSearchServer(const StringContainer& stop_words, SegmentMergePolicy merge_policy, TermFreqStorage term_freq_storage)
+    : stop_words_(stop_words.begin(), stop_words.end())
+    , merge_policy_(merge_policy)
+    , term_freq_storage_(term_freq_storage)
+    , tokenizer_(stop_words_, term_freq_storage_)
+    , buffer_(std::make_unique<SearchServer>(stop_words_, term_freq_storage_)) {
+    if (merge_policy_.buffer_document_count == 0 || merge_policy_.merge_factor < 2) {
+        throw std::invalid_argument("Invalid segment merge policy"s);
+    }
+    merge_thread_ = std::thread([this] {
+        RunMerges();
+        });
+}
+
+template <typename Scorer, typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate,
+    const PageRequest& page) const {
+    std::shared_lock lock(mutex_);
+    const TermStats term_stats = GetTermStats(raw_query);
+    // Every segment returns its own best offset + limit documents; the page is cut from their union.
+    const PageRequest segment_page{ 0, page.GetEnd(), page.search_after };
+
+    std::vector<Document> documents;
+    for (const Segment& segment : segments_) {
+        const auto segment_documents = segment.index->FindTopDocuments<Scorer>(policy, raw_query,
+            [&segment, &document_predicate](int document_id, DocumentStatus status, int rating) {
+                return segment.tombstones.count(document_id) == 0 && document_predicate(document_id, status, rating);
+            }, segment_page, term_stats);
+        documents.insert(documents.end(), segment_documents.begin(), segment_documents.end());
+    }
+    const auto buffer_documents = buffer_->FindTopDocuments<Scorer>(policy, raw_query, document_predicate, segment_page, term_stats);
+    documents.insert(documents.end(), buffer_documents.begin(), buffer_documents.end());
+
+    std::sort(documents.begin(), documents.end(), SearchServer::IsRankedHigher);
+    documents.erase(documents.begin(), documents.begin() + std::min(page.offset, documents.size()));
+    documents.resize(std::min(page.limit, documents.size()));
+    return documents;
+}
+
+template <typename Scorer, typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return FindTopDocuments<Scorer>(policy, raw_query, document_predicate, PageRequest{});
+}
+
+template <typename Scorer, typename ExecutionPolicy>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const {
+    return FindTopDocuments<Scorer>(policy, raw_query, DocumentStatusPredicate{ DocumentStatus::ACTUAL });
+}
@@ -0,0 +1,223 @@
+#include "shard_coordinator.h"
+
+#include "unix_socket.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t RECEIVE_BUFFER_SIZE = 64 * 1024;
+
+} // namespace
+
+ShardCoordinator::ShardCoordinator(std::vector<std::vector<std::string>> shard_replicas, ShardCoordinatorOptions options)
+    : options_(options) {
+    for (const auto& replica_paths : shard_replicas) {
+        if (replica_paths.empty()) {
+            throw std::invalid_argument("Every shard needs a replica"s);
+        }
+        auto& replicas = shards_.emplace_back();
+        for (const std::string& socket_path : replica_paths) {
+            replicas.push_back({ socket_path, -1, {} });
+        }
+    }
+}
+
+ShardCoordinator::~ShardCoordinator() {
+    for (auto& replicas : shards_) {
+        for (Replica& replica : replicas) {
+            Disconnect(replica);
+        }
+    }
+}
+
+CoordinatedResult ShardCoordinator::Find(std::string_view raw_query, ShardScorer scorer, DocumentStatus status, const PageRequest& page) {
+    if (page.search_after) {
+        throw std::invalid_argument("ShardCoordinator does not support search_after"s);
+    }
+    std::lock_guard lock(mutex_);
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + options_.deadline;
+    CoordinatedResult result;
+
+    // The statistics round gets half of the time, so that a shard too slow for it leaves the
+    // others time to search rather than taking the whole query down with it.
+    ShardMessage request;
+    request.type = ShardMessageType::STATS_REQUEST;
+    request.query = raw_query;
+    const auto stats_responses = RunRound(request, std::vector<bool>(shards_.size(), true), start + options_.deadline / 2,
+        result.hedged_request_count);
+    std::vector<bool> wanted(shards_.size(), false);
+    for (size_t shard = 0; shard < shards_.size(); ++shard) {
+        if (!stats_responses[shard]) {
+            continue;
+        }
+        const TermStats& shard_stats = stats_responses[shard]->term_stats;
+        request.term_stats.document_count += shard_stats.document_count;
+        request.term_stats.total_word_count += shard_stats.total_word_count;
+        for (const auto& [word, document_freq] : shard_stats.document_freqs) {
+            request.term_stats.document_freqs[word] += document_freq;
+        }
+        wanted[shard] = true;
+    }
+
+    request.type = ShardMessageType::SEARCH_REQUEST;
+    request.scorer = scorer;
+    request.status = status;
+    request.result_limit = static_cast<uint32_t>(std::min<size_t>(page.GetEnd(), UINT32_MAX));
+    const auto search_responses = RunRound(request, wanted, deadline, result.hedged_request_count);
+    for (size_t shard = 0; shard < shards_.size(); ++shard) {
+        if (!search_responses[shard]) {
+            result.missing_shards.push_back(shard);
+            continue;
+        }
+        const auto& documents = search_responses[shard]->documents;
+        result.documents.insert(result.documents.end(), documents.begin(), documents.end());
+    }
+    const size_t end = std::min(page.GetEnd(), result.documents.size());
+    std::partial_sort(result.documents.begin(), result.documents.begin() + end, result.documents.end(), SearchServer::IsRankedHigher);
+    result.documents.resize(end);
+    result.documents.erase(result.documents.begin(), result.documents.begin() + std::min(page.offset, result.documents.size()));
+    return result;
+}
+
+// Every replica of a shard gets the same request id, so whichever answers first answers the
+// shard, and answers to earlier requests, which a slow replica may still send, are told apart.
+std::vector<std::optional<ShardMessage>> ShardCoordinator::RunRound(ShardMessage request, const std::vector<bool>& wanted,
+    std::chrono::steady_clock::time_point deadline, size_t& hedged_request_count) {
+    struct PendingShard {
+        uint64_t request_id = 0;
+        size_t next_replica = 0;
+        std::chrono::steady_clock::time_point hedge_at = std::chrono::steady_clock::time_point::max();
+    };
+    std::vector<std::optional<ShardMessage>> responses(shards_.size());
+    std::vector<PendingShard> pending(shards_.size());
+
+    // Sends to the next replica that takes the request; once none is left, the shard waits for the ones already asked.
+    const auto send_to_next_replica = [&](size_t shard) {
+        PendingShard& pending_shard = pending[shard];
+        pending_shard.hedge_at = std::chrono::steady_clock::time_point::max();
+        while (pending_shard.next_replica < shards_[shard].size()) {
+            Replica& replica = shards_[shard][pending_shard.next_replica++];
+            const auto now = std::chrono::steady_clock::now();
+            request.request_id = pending_shard.request_id;
+            request.time_budget = std::chrono::duration_cast<std::chrono::microseconds>(deadline - now);
+            if (Send(replica, request)) {
+                pending_shard.hedge_at = now + options_.hedge_delay;
+                return;
+            }
+        }
+    };
+    size_t waiting_count = 0;
+    for (size_t shard = 0; shard < shards_.size(); ++shard) {
+        if (wanted[shard]) {
+            pending[shard].request_id = ++next_request_id_;
+            send_to_next_replica(shard);
+            ++waiting_count;
+        }
+    }
+
+    std::vector<pollfd> fds;
+    std::vector<std::pair<size_t, size_t>> fd_replicas;
+    ShardMessage response;
+    while (waiting_count > 0) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            break;
+        }
+        auto wake_up_at = deadline;
+        fds.clear();
+        fd_replicas.clear();
+        for (size_t shard = 0; shard < shards_.size(); ++shard) {
+            if (!wanted[shard] || responses[shard]) {
+                continue;
+            }
+            if (pending[shard].hedge_at <= now) {
+                ++hedged_request_count;
+                send_to_next_replica(shard);
+            }
+            wake_up_at = std::min(wake_up_at, pending[shard].hedge_at);
+            for (size_t replica = 0; replica < pending[shard].next_replica; ++replica) {
+                if (shards_[shard][replica].fd >= 0) {
+                    fds.push_back({ shards_[shard][replica].fd, POLLIN, 0 });
+                    fd_replicas.emplace_back(shard, replica);
+                }
+            }
+        }
+        if (fds.empty() && wake_up_at == deadline) {
+            // Every replica of the shards still waited for has failed.
+            break;
+        }
+        const auto timeout = std::chrono::ceil<std::chrono::milliseconds>(wake_up_at - std::chrono::steady_clock::now());
+        if (poll(fds.data(), fds.size(), std::max<int>(0, timeout.count())) < 0 && errno != EINTR) {
+            throw std::runtime_error("Cannot poll shard connections"s);
+        }
+
+        for (size_t i = 0; i < fds.size(); ++i) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            const auto [shard, replica_index] = fd_replicas[i];
+            Replica& replica = shards_[shard][replica_index];
+            const size_t old_size = replica.input.size();
+            replica.input.resize(old_size + RECEIVE_BUFFER_SIZE);
+            const ssize_t size = read(replica.fd, replica.input.data() + old_size, RECEIVE_BUFFER_SIZE);
+            replica.input.resize(old_size + std::max<ssize_t>(size, 0));
+            bool failed = size == 0 || (size < 0 && errno != EINTR);
+            try {
+                size_t position = 0;
+                while (ReadShardMessage(replica.input, position, response)) {
+                    if (response.request_id != pending[shard].request_id || responses[shard]) {
+                        continue;
+                    }
+                    if (response.type == ShardMessageType::ERROR_RESPONSE) {
+                        throw std::invalid_argument(response.error);
+                    }
+                    responses[shard] = std::move(response);
+                    --waiting_count;
+                }
+                replica.input.erase(0, position);
+            }
+            catch (const std::runtime_error&) {
+                failed = true;
+            }
+            if (failed) {
+                Disconnect(replica);
+                // The shard need not wait out the hedge delay for a replica that is gone.
+                if (!responses[shard]) {
+                    pending[shard].hedge_at = std::min(pending[shard].hedge_at, std::chrono::steady_clock::now());
+                }
+            }
+        }
+    }
+    return responses;
+}
+
+bool ShardCoordinator::Send(Replica& replica, const ShardMessage& request) {
+    std::string output;
+    AppendShardMessage(output, request);
+    try {
+        if (replica.fd < 0) {
+            replica.fd = ConnectUnixSocket(replica.socket_path);
+        }
+        SendAll(replica.fd, output);
+        return true;
+    }
+    catch (const std::runtime_error&) {
+        Disconnect(replica);
+        return false;
+    }
+}
+
+void ShardCoordinator::Disconnect(Replica& replica) {
+    if (replica.fd >= 0) {
+        close(replica.fd);
+        replica.fd = -1;
+    }
+    replica.input.clear();
+}
\ No newline at end of file
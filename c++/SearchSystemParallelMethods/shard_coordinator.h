@@ -0,0 +1,85 @@
+#pragma once
+
+#include "search_server.h"
+#include "shard_protocol.h"
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+struct ShardCoordinatorOptions {
+    // How long a query may take; shards that have not answered by then are left out. The
+    // statistics round has the first half of it.
+    std::chrono::milliseconds deadline{ 100 };
+    // A shard that has not answered this long after a request gets the request again at its
+    // next replica, and the first answer wins.
+    std::chrono::milliseconds hedge_delay{ 10 };
+};
+
+struct CoordinatedResult {
+    std::vector<Document> documents;
+    // Shards that did not answer in time, or whose replicas all failed. Their documents are
+    // missing, and if they missed the statistics round, their share of the word statistics too.
+    std::vector<size_t> missing_shards;
+    // Requests sent to a further replica of a shard that was slow to answer.
+    size_t hedged_request_count = 0;
+
+    bool IsComplete() const {
+        return missing_shards.empty();
+    }
+};
+
+// Fans FindTopDocuments out to ShardServers over Unix domain sockets, one connection per
+// replica kept open between queries. A query is two rounds, word statistics and search (see
+// shard_protocol.h), within one deadline. A complete result is exactly what one
+// SearchServer holding every shard's documents returns. Queries are served one at a time.
+class ShardCoordinator {
+public:
+    // shard_replicas[shard] lists the socket paths of the servers holding the shard, preferred first.
+    explicit ShardCoordinator(std::vector<std::vector<std::string>> shard_replicas, ShardCoordinatorOptions options = {});
+    ~ShardCoordinator();
+    ShardCoordinator(const ShardCoordinator&) = delete;
+    ShardCoordinator& operator=(const ShardCoordinator&) = delete;
+
+    // Paging takes offset and limit; a search_after cursor is not supported. Throws
+    // std::invalid_argument for a query the shards reject.
+    template <typename Scorer = TfIdfScorer>
+    CoordinatedResult FindTopDocuments(std::string_view raw_query, DocumentStatus status, const PageRequest& page);
+    template <typename Scorer = TfIdfScorer>
+    CoordinatedResult FindTopDocuments(std::string_view raw_query);
+
+private:
+    struct Replica {
+        std::string socket_path;
+        int fd = -1;
+        // Received data not yet parsed into messages.
+        std::string input;
+    };
+
+    // Sends request to every shard in wanted and waits for their answers until deadline,
+    // hedging slow shards; the result has one entry per shard, empty if it did not answer.
+    std::vector<std::optional<ShardMessage>> RunRound(ShardMessage request, const std::vector<bool>& wanted,
+        std::chrono::steady_clock::time_point deadline, size_t& hedged_request_count);
+    CoordinatedResult Find(std::string_view raw_query, ShardScorer scorer, DocumentStatus status, const PageRequest& page);
+    bool Send(Replica& replica, const ShardMessage& request);
+    void Disconnect(Replica& replica);
+
+    const ShardCoordinatorOptions options_;
+    std::mutex mutex_;
+    std::vector<std::vector<Replica>> shards_;
+    uint64_t next_request_id_ = 0;
+};
+
+template <typename Scorer>
+CoordinatedResult ShardCoordinator::FindTopDocuments(std::string_view raw_query, DocumentStatus status, const PageRequest& page) {
+    static_assert(std::is_same_v<Scorer, TfIdfScorer> || std::is_same_v<Scorer, Bm25Scorer>, "Shard servers score with TfIdfScorer or Bm25Scorer");
+    return Find(raw_query, std::is_same_v<Scorer, Bm25Scorer> ? ShardScorer::BM25 : ShardScorer::TF_IDF, status, page);
+}
+
+template <typename Scorer>
+CoordinatedResult ShardCoordinator::FindTopDocuments(std::string_view raw_query) {
+    return FindTopDocuments<Scorer>(raw_query, DocumentStatus::ACTUAL, PageRequest{});
+}
\ No newline at end of file
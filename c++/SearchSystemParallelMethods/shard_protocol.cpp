@@ -0,0 +1,163 @@
+#include "shard_protocol.h"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace std::literals;
+
+namespace {
+
+constexpr uint32_t MAX_MESSAGE_SIZE = 64u << 20;
+
+template <typename T>
+void Put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void PutString(std::string& out, std::string_view value) {
+    Put(out, static_cast<uint32_t>(value.size()));
+    out += value;
+}
+
+// Reads the fields of one message; running out of data means the message is corrupt.
+class MessageReader {
+public:
+    explicit MessageReader(std::string_view data) : data_(data) {
+    }
+
+    template <typename T>
+    T Get() {
+        T value;
+        Check(sizeof(T));
+        std::memcpy(&value, data_.data(), sizeof(T));
+        data_.remove_prefix(sizeof(T));
+        return value;
+    }
+
+    std::string GetString() {
+        const uint32_t size = Get<uint32_t>();
+        Check(size);
+        std::string value(data_.substr(0, size));
+        data_.remove_prefix(size);
+        return value;
+    }
+
+    bool IsEmpty() const {
+        return data_.empty();
+    }
+
+private:
+    void Check(size_t size) const {
+        if (data_.size() < size) {
+            throw std::runtime_error("Corrupt shard message"s);
+        }
+    }
+
+    std::string_view data_;
+};
+
+} // namespace
+
+void AppendShardMessage(std::string& out, const ShardMessage& message) {
+    const size_t size_position = out.size();
+    Put(out, uint32_t{ 0 });
+    Put(out, static_cast<uint8_t>(message.type));
+    Put(out, message.request_id);
+    switch (message.type) {
+    case ShardMessageType::STATS_REQUEST:
+    case ShardMessageType::SEARCH_REQUEST:
+        Put(out, static_cast<int64_t>(message.time_budget.count()));
+        PutString(out, message.query);
+        if (message.type == ShardMessageType::STATS_REQUEST) {
+            break;
+        }
+        Put(out, static_cast<uint8_t>(message.scorer));
+        Put(out, static_cast<int32_t>(message.status));
+        Put(out, message.result_limit);
+        [[fallthrough]];
+    case ShardMessageType::STATS_RESPONSE:
+        Put(out, static_cast<int32_t>(message.term_stats.document_count));
+        Put(out, message.term_stats.total_word_count);
+        Put(out, static_cast<uint32_t>(message.term_stats.document_freqs.size()));
+        for (const auto& [word, document_freq] : message.term_stats.document_freqs) {
+            PutString(out, word);
+            Put(out, static_cast<int32_t>(document_freq));
+        }
+        break;
+    case ShardMessageType::SEARCH_RESPONSE:
+        Put(out, static_cast<uint32_t>(message.documents.size()));
+        for (const Document& document : message.documents) {
+            Put(out, static_cast<int32_t>(document.id));
+            Put(out, document.relevance);
+            Put(out, static_cast<int32_t>(document.rating));
+        }
+        break;
+    case ShardMessageType::ERROR_RESPONSE:
+        PutString(out, message.error);
+        break;
+    }
+    const uint32_t size = static_cast<uint32_t>(out.size() - size_position - sizeof(uint32_t));
+    std::memcpy(out.data() + size_position, &size, sizeof(size));
+}
+
+bool ReadShardMessage(std::string_view data, size_t& position, ShardMessage& message) {
+    uint32_t size;
+    if (data.size() - position < sizeof(size)) {
+        return false;
+    }
+    std::memcpy(&size, data.data() + position, sizeof(size));
+    if (size > MAX_MESSAGE_SIZE) {
+        throw std::runtime_error("Corrupt shard message"s);
+    }
+    if (data.size() - position - sizeof(size) < size) {
+        return false;
+    }
+    MessageReader reader(data.substr(position + sizeof(size), size));
+    const uint8_t type = reader.Get<uint8_t>();
+    if (type > static_cast<uint8_t>(ShardMessageType::ERROR_RESPONSE)) {
+        throw std::runtime_error("Corrupt shard message"s);
+    }
+    message = ShardMessage{};
+    message.type = static_cast<ShardMessageType>(type);
+    message.request_id = reader.Get<uint64_t>();
+    switch (message.type) {
+    case ShardMessageType::STATS_REQUEST:
+    case ShardMessageType::SEARCH_REQUEST:
+        message.time_budget = std::chrono::microseconds(reader.Get<int64_t>());
+        message.query = reader.GetString();
+        if (message.type == ShardMessageType::STATS_REQUEST) {
+            break;
+        }
+        message.scorer = static_cast<ShardScorer>(reader.Get<uint8_t>());
+        message.status = static_cast<DocumentStatus>(reader.Get<int32_t>());
+        message.result_limit = reader.Get<uint32_t>();
+        [[fallthrough]];
+    case ShardMessageType::STATS_RESPONSE: {
+        message.term_stats.document_count = reader.Get<int32_t>();
+        message.term_stats.total_word_count = reader.Get<int64_t>();
+        const uint32_t word_count = reader.Get<uint32_t>();
+        for (uint32_t i = 0; i < word_count; ++i) {
+            std::string word = reader.GetString();
+            message.term_stats.document_freqs.emplace(std::move(word), reader.Get<int32_t>());
+        }
+        break;
+    }
+    case ShardMessageType::SEARCH_RESPONSE: {
+        const uint32_t document_count = reader.Get<uint32_t>();
+        for (uint32_t i = 0; i < document_count; ++i) {
+            const int id = reader.Get<int32_t>();
+            const double relevance = reader.Get<double>();
+            message.documents.emplace_back(id, relevance, reader.Get<int32_t>());
+        }
+        break;
+    }
+    case ShardMessageType::ERROR_RESPONSE:
+        message.error = reader.GetString();
+        break;
+    }
+    if (!reader.IsEmpty()) {
+        throw std::runtime_error("Corrupt shard message"s);
+    }
+    position += sizeof(size) + size;
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "document.h"
+#include "scoring.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Messages between a ShardCoordinator and its ShardServers. A query takes two round trips:
+// the coordinator sums every shard's TermStats for the query, then sends the sum with the
+// search so that all shards weigh words alike and their results merge exactly.
+enum class ShardMessageType : uint8_t {
+    STATS_REQUEST,
+    STATS_RESPONSE,
+    SEARCH_REQUEST,
+    SEARCH_RESPONSE,
+    ERROR_RESPONSE,
+};
+
+enum class ShardScorer : uint8_t {
+    TF_IDF,
+    BM25,
+};
+
+// One struct for every type; each type uses the fields noted.
+struct ShardMessage {
+    ShardMessageType type = ShardMessageType::ERROR_RESPONSE;
+    // Chosen by the coordinator and echoed in the response.
+    uint64_t request_id = 0;
+    // Requests: what was left of the coordinator's deadline when it sent the request. The
+    // shard drops a request it could not answer in time, since nobody waits for the answer.
+    std::chrono::microseconds time_budget{};
+    // Requests.
+    std::string query;
+    // Search requests.
+    ShardScorer scorer = ShardScorer::TF_IDF;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    uint32_t result_limit = 0;
+    // Stats responses and search requests.
+    TermStats term_stats;
+    // Search responses.
+    std::vector<Document> documents;
+    // Error responses.
+    std::string error;
+};
+
+// A frame is the message's size as uint32, then its fields in the order above, numbers in
+// host byte order and strings as a uint32 size and the bytes: the ends run on one machine, or
+// on machines of one architecture.
+void AppendShardMessage(std::string& out, const ShardMessage& message);
+// Reads the frame at position and moves position past it; returns false if data ends inside
+// the frame. Throws std::runtime_error for data that is not a message.
+bool ReadShardMessage(std::string_view data, size_t& position, ShardMessage& message);
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "shard_server.h"
+
+#include "unix_socket.h"
+
+#include <cerrno>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t RECEIVE_BUFFER_SIZE = 64 * 1024;
+
+} // namespace
+
+ShardServer::ShardServer(const SearchServer& index, const std::string& socket_path, ShardServerOptions options)
+    : index_(index)
+    , socket_path_(socket_path)
+    , options_(options) {
+    if (pipe2(stop_fds_, O_CLOEXEC) != 0) {
+        throw std::runtime_error("Cannot create a pipe"s);
+    }
+    try {
+        listen_fd_ = ListenUnixSocket(socket_path_);
+    }
+    catch (...) {
+        close(stop_fds_[0]);
+        close(stop_fds_[1]);
+        throw;
+    }
+}
+
+ShardServer::~ShardServer() {
+    close(listen_fd_);
+    close(stop_fds_[0]);
+    close(stop_fds_[1]);
+    unlink(socket_path_.c_str());
+}
+
+void ShardServer::Serve() {
+    // Unread input of every connection, by descriptor.
+    std::map<int, std::string> connections;
+    std::vector<pollfd> fds;
+    ShardMessage request;
+    ShardMessage response;
+    std::string output;
+    while (true) {
+        fds.assign({ { stop_fds_[0], POLLIN, 0 }, { listen_fd_, POLLIN, 0 } });
+        for (const auto& [fd, input] : connections) {
+            fds.push_back({ fd, POLLIN, 0 });
+        }
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Cannot poll shard connections"s);
+        }
+        if (fds[0].revents != 0) {
+            break;
+        }
+        if (fds[1].revents != 0) {
+            const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd >= 0) {
+                connections.emplace(fd, std::string());
+            }
+        }
+        for (size_t i = 2; i < fds.size(); ++i) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            const int fd = fds[i].fd;
+            std::string& input = connections[fd];
+            const size_t old_size = input.size();
+            input.resize(old_size + RECEIVE_BUFFER_SIZE);
+            const ssize_t size = read(fd, input.data() + old_size, RECEIVE_BUFFER_SIZE);
+            input.resize(old_size + std::max<ssize_t>(size, 0));
+            bool closed = size == 0 || (size < 0 && errno != EINTR);
+            const auto received_at = std::chrono::steady_clock::now();
+            try {
+                size_t position = 0;
+                output.clear();
+                while (!closed && ReadShardMessage(input, position, request)) {
+                    if (Answer(request, received_at, response)) {
+                        AppendShardMessage(output, response);
+                    }
+                }
+                input.erase(0, position);
+                SendAll(fd, output);
+            }
+            catch (const std::runtime_error&) {
+                closed = true;
+            }
+            if (closed) {
+                close(fd);
+                connections.erase(fd);
+            }
+        }
+    }
+    for (const auto& [fd, input] : connections) {
+        close(fd);
+    }
+}
+
+void ShardServer::Stop() {
+    const char byte = 0;
+    while (write(stop_fds_[1], &byte, 1) < 0 && errno == EINTR) {
+    }
+}
+
+uint64_t ShardServer::GetAnsweredCount() const {
+    return answered_count_;
+}
+
+uint64_t ShardServer::GetDroppedCount() const {
+    return dropped_count_;
+}
+
+bool ShardServer::Answer(const ShardMessage& request, std::chrono::steady_clock::time_point received_at, ShardMessage& response) {
+    // Nobody waits for the answer once the budget is gone, so the work is not even started.
+    const auto is_expired = [&] {
+        return std::chrono::steady_clock::now() - received_at > request.time_budget;
+    };
+    if (!is_expired()) {
+        std::this_thread::sleep_for(options_.response_delay);
+    }
+    if (is_expired()) {
+        ++dropped_count_;
+        return false;
+    }
+    response = ShardMessage{};
+    response.request_id = request.request_id;
+    try {
+        if (request.type == ShardMessageType::STATS_REQUEST) {
+            response.type = ShardMessageType::STATS_RESPONSE;
+            index_.AddTermStats(request.query, response.term_stats);
+        }
+        else if (request.type == ShardMessageType::SEARCH_REQUEST) {
+            response.type = ShardMessageType::SEARCH_RESPONSE;
+            const DocumentStatusPredicate predicate{ request.status };
+            const PageRequest page{ 0, request.result_limit };
+            response.documents = request.scorer == ShardScorer::BM25
+                ? index_.FindTopDocuments<Bm25Scorer>(std::execution::seq, request.query, predicate, page, request.term_stats)
+                : index_.FindTopDocuments<TfIdfScorer>(std::execution::seq, request.query, predicate, page, request.term_stats);
+        }
+        else {
+            throw std::invalid_argument("Unexpected shard message"s);
+        }
+    }
+    catch (const std::invalid_argument& error) {
+        response = ShardMessage{};
+        response.type = ShardMessageType::ERROR_RESPONSE;
+        response.request_id = request.request_id;
+        response.error = error.what();
+    }
+    ++answered_count_;
+    return true;
+}
\ No newline at end of file
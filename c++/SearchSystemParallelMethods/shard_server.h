@@ -0,0 +1,44 @@
+#pragma once
+
+#include "search_server.h"
+#include "shard_protocol.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+struct ShardServerOptions {
+    // Added before every response, to stand in for a slow or overloaded machine in tests.
+    std::chrono::milliseconds response_delay{};
+};
+
+// Serves one shard's index to ShardCoordinators over a Unix domain socket. Requests are
+// answered one at a time in arrival order; a request whose time budget runs out before it is
+// answered is dropped. The index must not change while Serve runs.
+class ShardServer {
+public:
+    ShardServer(const SearchServer& index, const std::string& socket_path, ShardServerOptions options = {});
+    ~ShardServer();
+    ShardServer(const ShardServer&) = delete;
+    ShardServer& operator=(const ShardServer&) = delete;
+
+    // Returns after Stop.
+    void Serve();
+    // May be called from any thread, or from a signal handler.
+    void Stop();
+
+    uint64_t GetAnsweredCount() const;
+    uint64_t GetDroppedCount() const;
+
+private:
+    // Returns false if the request expired.
+    bool Answer(const ShardMessage& request, std::chrono::steady_clock::time_point received_at, ShardMessage& response);
+
+    const SearchServer& index_;
+    const std::string socket_path_;
+    const ShardServerOptions options_;
+    int listen_fd_ = -1;
+    int stop_fds_[2] = { -1, -1 };
+    std::atomic<uint64_t> answered_count_ = 0;
+    std::atomic<uint64_t> dropped_count_ = 0;
+};
\ No newline at end of file
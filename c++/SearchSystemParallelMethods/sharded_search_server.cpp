@@ -0,0 +1,72 @@
+#include "sharded_search_server.h"
+
+ShardedSearchServer::ShardedSearchServer(std::string_view stop_words_text, size_t shard_count, TermFreqStorage term_freq_storage)
+    : ShardedSearchServer(SplitIntoWords(stop_words_text), shard_count, term_freq_storage) {
+}
+
+ShardedSearchServer::ShardedSearchServer(const std::string& stop_words_text, size_t shard_count, TermFreqStorage term_freq_storage)
+    : ShardedSearchServer(SplitIntoWords(stop_words_text), shard_count, term_freq_storage) {
+}
+
+void ShardedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    Shard& shard = GetShard(document_id);
+    // Tokenizing reads only the stop words, so it does not hold up the shard's queries.
+    const TokenizedDocument tokenized_document = shard.index->TokenizeDocument(document_id, document, status, ratings);
+    std::unique_lock lock(shard.mutex);
+    shard.index->AddTokenizedDocument(tokenized_document);
+}
+
+void ShardedSearchServer::RemoveDocument(int document_id) {
+    Shard& shard = GetShard(document_id);
+    std::unique_lock lock(shard.mutex);
+    shard.index->RemoveDocument(document_id);
+}
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(std::execution::seq, raw_query, status);
+}
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(std::execution::seq, raw_query);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> ShardedSearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
+    return MatchDocument(std::execution::seq, raw_query, document_id);
+}
+
+int ShardedSearchServer::GetDocumentCount() const {
+    int document_count = 0;
+    for (const Shard& shard : shards_) {
+        std::shared_lock lock(shard.mutex);
+        document_count += shard.index->GetDocumentCount();
+    }
+    return document_count;
+}
+
+bool ShardedSearchServer::ContainsDocument(int document_id) const {
+    const Shard& shard = GetShard(document_id);
+    std::shared_lock lock(shard.mutex);
+    return shard.index->ContainsDocument(document_id);
+}
+
+size_t ShardedSearchServer::GetShardCount() const {
+    return shards_.size();
+}
+
+std::vector<int> ShardedSearchServer::GetShardSizes() const {
+    std::vector<int> sizes;
+    for (const Shard& shard : shards_) {
+        std::shared_lock lock(shard.mutex);
+        sizes.push_back(shard.index->GetDocumentCount());
+    }
+    return sizes;
+}
+
+// Negative ids are rejected by the shard they land on, like by any SearchServer.
+const ShardedSearchServer::Shard& ShardedSearchServer::GetShard(int document_id) const {
+    return shards_[static_cast<unsigned>(document_id) % shards_.size()];
+}
+
+ShardedSearchServer::Shard& ShardedSearchServer::GetShard(int document_id) {
+    return shards_[static_cast<unsigned>(document_id) % shards_.size()];
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "search_server.h"
+#include "thread_pool.h"
+
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <vector>
+
+// Splits one corpus over shard_count SearchServers by document id, each with its own index
+// arena and lock. A query runs on every shard in parallel, each shard returning its own best
+// offset + limit documents, and the page is cut from their union. The shards weigh words by
+// the document frequencies summed over all of them, so the results are exactly those of one
+// SearchServer holding the same documents. A query holds every shard's shared lock for its
+// duration, so it sees all shards at one point in time; writes lock only their own shard and
+// go on in parallel on different shards.
+class ShardedSearchServer {
+public:
+    template <typename StringContainer>
+    ShardedSearchServer(const StringContainer& stop_words, size_t shard_count, TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE);
+    ShardedSearchServer(std::string_view stop_words_text, size_t shard_count, TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE);
+    ShardedSearchServer(const std::string& stop_words_text, size_t shard_count, TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE);
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    void RemoveDocument(int document_id);
+
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, const PageRequest& page) const;
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const;
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    template <typename Scorer = TfIdfScorer, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    template <typename ExecutionPolicy>
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(ExecutionPolicy&& policy, std::string_view raw_query, int document_id) const;
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+
+    int GetDocumentCount() const;
+    bool ContainsDocument(int document_id) const;
+    size_t GetShardCount() const;
+    std::vector<int> GetShardSizes() const;
+
+private:
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unique_ptr<SearchServer> index;
+    };
+
+    // Documents go to shards round robin by id.
+    const Shard& GetShard(int document_id) const;
+    Shard& GetShard(int document_id);
+
+    std::vector<Shard> shards_;
+};
+
+template <typename StringContainer>
+ShardedSearchServer::ShardedSearchServer(const StringContainer& stop_words, size_t shard_count, TermFreqStorage term_freq_storage)
+    : shards_(shard_count) {
+    if (shard_count == 0) {
+        throw std::invalid_argument("At least one shard is needed"s);
+    }
+    for (Shard& shard : shards_) {
+        shard.index = std::make_unique<SearchServer>(stop_words, term_freq_storage);
+    }
+}
+
+template <typename Scorer, typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate,
+    const PageRequest& page) const {
+    std::vector<std::shared_lock<std::shared_mutex>> locks;
+    locks.reserve(shards_.size());
+    for (const Shard& shard : shards_) {
+        locks.emplace_back(shard.mutex);
+    }
+    // Parsing here throws for an invalid query before any shard starts.
+    TermStats term_stats;
+    for (const Shard& shard : shards_) {
+        shard.index->AddTermStats(raw_query, term_stats);
+    }
+    const PageRequest shard_page{ 0, page.GetEnd(), page.search_after };
+
+    std::vector<std::vector<Document>> shard_documents(shards_.size());
+    Transform(policy, shards_.begin(), shards_.end(), shard_documents.begin(), [&](const Shard& shard) {
+        return shard.index->FindTopDocuments<Scorer>(policy, raw_query, document_predicate, shard_page, term_stats);
+        });
+
+    std::vector<Document> documents;
+    for (const auto& documents_of_shard : shard_documents) {
+        documents.insert(documents.end(), documents_of_shard.begin(), documents_of_shard.end());
+    }
+    const size_t end = std::min(page.GetEnd(), documents.size());
+    std::partial_sort(documents.begin(), documents.begin() + end, documents.end(), SearchServer::IsRankedHigher);
+    documents.resize(end);
+    documents.erase(documents.begin(), documents.begin() + std::min(page.offset, documents.size()));
+    return documents;
+}
+
+template <typename Scorer, typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return FindTopDocuments<Scorer>(policy, raw_query, document_predicate, PageRequest{});
+}
+
+template <typename Scorer, typename ExecutionPolicy>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments<Scorer>(policy, raw_query, DocumentStatusPredicate{ status });
+}
+
+template <typename Scorer, typename ExecutionPolicy>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const {
+    return FindTopDocuments<Scorer>(policy, raw_query, DocumentStatus::ACTUAL);
+}
+
+template <typename ExecutionPolicy>
+std::tuple<std::vector<std::string_view>, DocumentStatus> ShardedSearchServer::MatchDocument(ExecutionPolicy&& policy, std::string_view raw_query,
+    int document_id) const {
+    const Shard& shard = GetShard(document_id);
+    std::shared_lock lock(shard.mutex);
+    return shard.index->MatchDocument(policy, raw_query, document_id);
+}
\ No newline at end of file
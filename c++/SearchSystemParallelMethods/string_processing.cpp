@@ -1,5 +1,7 @@
 #include "string_processing.h"
 
+#include <algorithm>
+
 std::vector<std::string> SplitIntoWords(std::string_view text) {
     std::vector<std::string> words;
     std::string word;
@@ -19,4 +21,34 @@ std::vector<std::string> SplitIntoWords(std::string_view text) {
     }
 
     return words;
+}
+
+void SplitIntoWords(std::string_view text, std::vector<std::string>& words) {
+    size_t word_count = 0;
+    size_t word_begin = 0;
+    while (word_begin < text.size()) {
+        if (text[word_begin] == ' ') {
+            ++word_begin;
+            continue;
+        }
+        const size_t word_end = std::min(text.find(' ', word_begin), text.size());
+        if (word_count == words.size()) {
+            words.emplace_back();
+        }
+        words[word_count++].assign(text.substr(word_begin, word_end - word_begin));
+        word_begin = word_end;
+    }
+    words.resize(word_count);
+}
+
+bool ParseNumberedName(std::string_view name, std::string_view prefix, std::string_view suffix, uint64_t& number) {
+    if (name.size() <= prefix.size() + suffix.size() || name.substr(0, prefix.size()) != prefix || name.substr(name.size() - suffix.size()) != suffix) {
+        return false;
+    }
+    const std::string_view digits = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+    if (!std::all_of(digits.begin(), digits.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return false;
+    }
+    number = std::stoull(std::string(digits));
+    return true;
 }
\ No newline at end of file
@@ -1,15 +1,21 @@
 #pragma once
 
+#include <cstdint>
 #include <set>
 #include <string>
 #include <vector>
 #include <string_view>
 
 std::vector<std::string> SplitIntoWords(std::string_view text);
+// Same split into a reused buffer: strings already in words keep their capacity.
+void SplitIntoWords(std::string_view text, std::vector<std::string>& words);
+
+// Matches names like <prefix><number><suffix>, as in "wal-12.log", and extracts the number.
+bool ParseNumberedName(std::string_view name, std::string_view prefix, std::string_view suffix, uint64_t& number);
 
 template <typename StringContainer>
-std::set<std::string> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
-    std::set<std::string> non_empty_strings;
+std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
+    std::set<std::string, std::less<>> non_empty_strings;
     for (const std::string& str : strings) {
         if (!str.empty()) {
             non_empty_strings.insert(str);
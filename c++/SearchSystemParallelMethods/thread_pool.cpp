@@ -0,0 +1,205 @@
+#include "thread_pool.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+thread_local WorkerScratch* thread_scratch = nullptr;
+thread_local bool thread_scratch_leased = false;
+thread_local const void* current_pool = nullptr;
+thread_local size_t current_worker_index = 0;
+
+WorkerScratch& GetThreadScratch() {
+    if (thread_scratch == nullptr) {
+        static thread_local WorkerScratch scratch;
+        thread_scratch = &scratch;
+    }
+    return *thread_scratch;
+}
+
+void PinCurrentThread(size_t worker_index) {
+#ifdef __linux__
+    const unsigned cpu_count = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(worker_index % cpu_count, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+}
+
+} // namespace
+
+ScratchLease::ScratchLease() {
+    if (thread_scratch_leased) {
+        private_scratch_ = std::make_unique<WorkerScratch>();
+        scratch_ = private_scratch_.get();
+    }
+    else {
+        thread_scratch_leased = true;
+        scratch_ = &GetThreadScratch();
+    }
+}
+
+ScratchLease::~ScratchLease() {
+    if (!private_scratch_) {
+        thread_scratch_leased = false;
+    }
+}
+
+// Indices are claimed in small chunks, so uneven bodies still balance. Helper tasks that
+// start after every index is claimed return without touching body.
+struct ThreadPool::ParallelForJob {
+    ParallelForJob(size_t count, size_t chunk_size, const std::function<void(size_t)>& body) : count(count), chunk_size(chunk_size), body(body) {
+    }
+
+    void Run() {
+        size_t finished = 0;
+        for (size_t begin = next.fetch_add(chunk_size); begin < count; begin = next.fetch_add(chunk_size)) {
+            const size_t end = std::min(begin + chunk_size, count);
+            try {
+                for (size_t i = begin; i < end; ++i) {
+                    body(i);
+                }
+            }
+            catch (...) {
+                std::lock_guard guard(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            finished += end - begin;
+        }
+        if (finished > 0 && done.fetch_add(finished) + finished == count) {
+            std::lock_guard guard(mutex);
+            all_done.notify_all();
+        }
+    }
+
+    void Wait() {
+        std::unique_lock lock(mutex);
+        all_done.wait(lock, [this] {
+            return done == count;
+            });
+    }
+
+    const size_t count;
+    const size_t chunk_size;
+    const std::function<void(size_t)>& body;
+    std::atomic<size_t> next = 0;
+    std::atomic<size_t> done = 0;
+    std::mutex mutex;
+    std::condition_variable all_done;
+    std::exception_ptr error;
+};
+
+ThreadPool::ThreadPool(size_t thread_count, bool pin_threads) {
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_[i]->thread = std::thread([this, i, pin_threads] {
+            if (pin_threads) {
+                PinCurrentThread(i);
+            }
+            RunWorker(i);
+            });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard guard(sleep_mutex_);
+        stopping_ = true;
+    }
+    wake_up_.notify_all();
+    for (auto& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+size_t ThreadPool::GetThreadCount() const {
+    return workers_.size();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    const size_t chunk_size = std::max<size_t>(1, count / (CHUNKS_PER_THREAD * (workers_.size() + 1)));
+    auto job = std::make_shared<ParallelForJob>(count, chunk_size, body);
+    const size_t helper_count = std::min(count - 1, workers_.size());
+    for (size_t i = 0; i < helper_count; ++i) {
+        Submit([job] {
+            job->Run();
+            });
+    }
+    job->Run();
+    job->Wait();
+    if (job->error) {
+        std::rethrow_exception(job->error);
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    // Tasks spawned on a worker stay on its deque, where it finds them first.
+    const size_t worker_index = current_pool == this ? current_worker_index : next_worker_++ % workers_.size();
+    {
+        std::lock_guard guard(workers_[worker_index]->mutex);
+        workers_[worker_index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard guard(sleep_mutex_);
+        ++queued_task_count_;
+    }
+    wake_up_.notify_one();
+}
+
+bool ThreadPool::TryRunTask(size_t worker_index) {
+    std::function<void()> task;
+    for (size_t i = 0; i < workers_.size() && !task; ++i) {
+        Worker& victim = *workers_[(worker_index + i) % workers_.size()];
+        std::lock_guard guard(victim.mutex);
+        if (victim.tasks.empty()) {
+            continue;
+        }
+        if (i == 0) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+        }
+        else {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+    if (!task) {
+        return false;
+    }
+    {
+        std::lock_guard guard(sleep_mutex_);
+        --queued_task_count_;
+    }
+    task();
+    return true;
+}
+
+void ThreadPool::RunWorker(size_t worker_index) {
+    current_pool = this;
+    current_worker_index = worker_index;
+    thread_scratch = &workers_[worker_index]->scratch;
+    while (true) {
+        if (TryRunTask(worker_index)) {
+            continue;
+        }
+        std::unique_lock lock(sleep_mutex_);
+        wake_up_.wait(lock, [this] {
+            return stopping_ || queued_task_count_ > 0;
+            });
+        if (stopping_ && queued_task_count_ == 0) {
+            return;
+        }
+    }
+}
\ No newline at end of file
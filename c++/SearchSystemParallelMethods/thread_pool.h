@@ -0,0 +1,133 @@
+#pragma once
+
+#include "query_arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <execution>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Buffers one thread reuses from query to query; they keep the capacity they grew to.
+struct WorkerScratch {
+    std::vector<double> scores;
+    std::vector<uint32_t> slots;
+    std::vector<std::string> tokens;
+    QueryArena arena;
+};
+
+// Borrows the calling thread's scratch (the worker's own one on pool threads). A thread that
+// waits inside a parallel algorithm may start other work, so a nested lease gets a private instance.
+class ScratchLease {
+public:
+    ScratchLease();
+    ~ScratchLease();
+    ScratchLease(const ScratchLease&) = delete;
+    ScratchLease& operator=(const ScratchLease&) = delete;
+
+    WorkerScratch& operator*() const {
+        return *scratch_;
+    }
+
+    WorkerScratch* operator->() const {
+        return scratch_;
+    }
+
+private:
+    std::unique_ptr<WorkerScratch> private_scratch_;
+    WorkerScratch* scratch_;
+};
+
+// Work-stealing pool. Every worker owns a task deque: it pops its own tasks LIFO and steals
+// from the other deques FIFO when it runs dry. A ThreadPool can be passed wherever the
+// search server takes an execution policy.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t thread_count = std::max(1u, std::thread::hardware_concurrency()), bool pin_threads = false);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t GetThreadCount() const;
+
+    // Calls body(i) for every i in [0, count) and returns when all calls are done. The calling
+    // thread takes indices too, so nested ParallelFor calls cannot starve the pool. The first
+    // exception thrown by body is rethrown here.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+        WorkerScratch scratch;
+        std::thread thread;
+    };
+
+    struct ParallelForJob;
+
+    static constexpr size_t CHUNKS_PER_THREAD = 8;
+
+    void Submit(std::function<void()> task);
+    bool TryRunTask(size_t worker_index);
+    void RunWorker(size_t worker_index);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_up_;
+    size_t queued_task_count_ = 0;
+    bool stopping_ = false;
+    std::atomic<size_t> next_worker_ = 0;
+};
+
+template <typename ExecutionPolicy>
+constexpr bool IS_THREAD_POOL = std::is_same_v<std::decay_t<ExecutionPolicy>, ThreadPool>;
+
+// std::for_each / count_if / transform that also accept a ThreadPool as the policy.
+template <typename ExecutionPolicy, typename Iterator, typename Function>
+void ForEach(ExecutionPolicy&& policy, Iterator first, Iterator last, Function function) {
+    if constexpr (IS_THREAD_POOL<ExecutionPolicy>) {
+        policy.ParallelFor(std::distance(first, last), [first, &function](size_t i) {
+            function(*std::next(first, i));
+            });
+    }
+    else {
+        std::for_each(policy, first, last, function);
+    }
+}
+
+template <typename ExecutionPolicy, typename Iterator, typename Predicate>
+size_t CountIf(ExecutionPolicy&& policy, Iterator first, Iterator last, Predicate predicate) {
+    if constexpr (IS_THREAD_POOL<ExecutionPolicy>) {
+        std::atomic<size_t> count = 0;
+        policy.ParallelFor(std::distance(first, last), [first, &predicate, &count](size_t i) {
+            if (predicate(*std::next(first, i))) {
+                count.fetch_add(1, std::memory_order_relaxed);
+            }
+            });
+        return count;
+    }
+    else {
+        return std::count_if(policy, first, last, predicate);
+    }
+}
+
+template <typename ExecutionPolicy, typename InputIterator, typename OutputIterator, typename Function>
+void Transform(ExecutionPolicy&& policy, InputIterator first, InputIterator last, OutputIterator out, Function function) {
+    if constexpr (IS_THREAD_POOL<ExecutionPolicy>) {
+        policy.ParallelFor(std::distance(first, last), [first, out, &function](size_t i) {
+            *std::next(out, i) = function(*std::next(first, i));
+            });
+    }
+    else {
+        std::transform(policy, first, last, out, function);
+    }
+}
\ No newline at end of file
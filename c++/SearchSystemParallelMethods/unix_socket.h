@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Thin wrappers over stream sockets in the Unix domain; they throw std::runtime_error on
+// failure and return descriptors the caller closes.
+
+// Replaces whatever is at path with a listening socket.
+int ListenUnixSocket(const std::string& path, int backlog = 128);
+int ConnectUnixSocket(const std::string& path);
+void SetNonBlocking(int fd);
+// Writes all of data to a blocking socket; a closed peer is an error rather than a SIGPIPE.
+void SendAll(int fd, std::string_view data);
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "versioned_search_server.h"
+
+VersionedSearchServer::VersionedSearchServer(std::string_view stop_words_text, TermFreqStorage term_freq_storage, IndexHugePages huge_pages)
+    : VersionedSearchServer(SplitIntoWords(stop_words_text), term_freq_storage, huge_pages) {
+}
+
+VersionedSearchServer::VersionedSearchServer(const std::string& stop_words_text, TermFreqStorage term_freq_storage, IndexHugePages huge_pages)
+    : VersionedSearchServer(SplitIntoWords(stop_words_text), term_freq_storage, huge_pages) {
+}
+
+VersionedSearchServer::Snapshot VersionedSearchServer::GetSnapshot() const {
+    ReadIndicator& indicator = read_indicators_[epoch_.load()];
+    const size_t stripe = indicator.Arrive();
+    const int read_index = read_index_.load();
+    return Snapshot(indicator, stripe, instances_[read_index], instance_versions_[read_index]);
+}
+
+void VersionedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    Write([&](SearchServer& search_server) {
+        search_server.AddDocument(document_id, document, status, ratings);
+        });
+}
+
+void VersionedSearchServer::RemoveDocument(int document_id) {
+    Write([document_id](SearchServer& search_server) {
+        search_server.RemoveDocument(document_id);
+        });
+}
+
+uint64_t VersionedSearchServer::GetVersion() const {
+    return GetSnapshot().GetVersion();
+}
+
+// A reader that read the old epoch may still be about to read the old read_index_, so the
+// readers of the new epoch have to drain before the epoch flips back and the old ones after it.
+void VersionedSearchServer::WaitForReaders() {
+    const int epoch = epoch_.load();
+    while (!read_indicators_[1 - epoch].IsEmpty()) {
+        std::this_thread::yield();
+    }
+    epoch_.store(1 - epoch);
+    while (!read_indicators_[epoch].IsEmpty()) {
+        std::this_thread::yield();
+    }
+}
+
+VersionedSearchServer::Snapshot::Snapshot(ReadIndicator& indicator, size_t stripe, const SearchServer& search_server, uint64_t version)
+    : indicator_(&indicator)
+    , stripe_(stripe)
+    , search_server_(&search_server)
+    , version_(version) {
+}
+
+VersionedSearchServer::Snapshot::Snapshot(Snapshot&& other) noexcept
+    : indicator_(std::exchange(other.indicator_, nullptr))
+    , stripe_(other.stripe_)
+    , search_server_(other.search_server_)
+    , version_(other.version_) {
+}
+
+VersionedSearchServer::Snapshot::~Snapshot() {
+    if (indicator_ != nullptr) {
+        indicator_->Depart(stripe_);
+    }
+}
+
+size_t VersionedSearchServer::ReadIndicator::Arrive() {
+    static std::atomic<size_t> next_stripe = 0;
+    thread_local const size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % STRIPE_COUNT;
+    stripes_[stripe].reader_count.fetch_add(1);
+    return stripe;
+}
+
+void VersionedSearchServer::ReadIndicator::Depart(size_t stripe) {
+    stripes_[stripe].reader_count.fetch_sub(1);
+}
+
+bool VersionedSearchServer::ReadIndicator::IsEmpty() const {
+    return std::all_of(stripes_.begin(), stripes_.end(), [](const Stripe& stripe) {
+        return stripe.reader_count.load() == 0;
+        });
+}
\ No newline at end of file
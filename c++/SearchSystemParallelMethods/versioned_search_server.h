@@ -0,0 +1,121 @@
+#pragma once
+
+#include "search_server.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// Search server that answers queries while documents are added and removed. It keeps two
+// copies of the index (left-right scheme): readers use the published copy without locks,
+// the writer changes the other copy, publishes it, waits for the readers of the previous
+// epoch to leave the old copy and then replays the change on it. Every snapshot is one
+// consistent index version. Writers are serialized among themselves.
+class VersionedSearchServer {
+private:
+    class ReadIndicator;
+
+public:
+    // Pins one index version for as long as it lives. A writer waits for the snapshots of the
+    // previous epoch to be released, so hold a snapshot for a batch of reads, not indefinitely.
+    class Snapshot {
+    public:
+        Snapshot(Snapshot&& other) noexcept;
+        Snapshot& operator=(Snapshot&&) = delete;
+        ~Snapshot();
+
+        const SearchServer& operator*() const {
+            return *search_server_;
+        }
+
+        const SearchServer* operator->() const {
+            return search_server_;
+        }
+
+        uint64_t GetVersion() const {
+            return version_;
+        }
+
+    private:
+        friend class VersionedSearchServer;
+
+        Snapshot(ReadIndicator& indicator, size_t stripe, const SearchServer& search_server, uint64_t version);
+
+        ReadIndicator* indicator_;
+        size_t stripe_;
+        const SearchServer* search_server_;
+        uint64_t version_;
+    };
+
+    template <typename StringContainer>
+    explicit VersionedSearchServer(const StringContainer& stop_words, TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE,
+        IndexHugePages huge_pages = IndexHugePages::NONE);
+    explicit VersionedSearchServer(std::string_view stop_words_text, TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE,
+        IndexHugePages huge_pages = IndexHugePages::NONE);
+    explicit VersionedSearchServer(const std::string& stop_words_text, TermFreqStorage term_freq_storage = TermFreqStorage::DOUBLE,
+        IndexHugePages huge_pages = IndexHugePages::NONE);
+
+    // Wait-free: two atomic increments and a load.
+    Snapshot GetSnapshot() const;
+
+    // Each call publishes a new version. Throws like SearchServer, in which case nothing is published.
+    // Must not be called by a thread that holds a snapshot: it would wait for itself.
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    void RemoveDocument(int document_id);
+
+    uint64_t GetVersion() const;
+
+private:
+    // Count of the readers inside one epoch, striped over cache lines so that readers on
+    // different threads do not contend on one counter. Arrive returns the stripe to depart
+    // from, which keeps a snapshot released on another thread balanced.
+    class ReadIndicator {
+    public:
+        size_t Arrive();
+        void Depart(size_t stripe);
+        bool IsEmpty() const;
+
+    private:
+        static constexpr size_t STRIPE_COUNT = 16;
+
+        struct alignas(64) Stripe {
+            std::atomic<int64_t> reader_count = 0;
+        };
+
+        std::array<Stripe, STRIPE_COUNT> stripes_;
+    };
+
+    // change must behave identically on both copies; it runs on the unpublished one first,
+    // so if it throws there, the published copy is untouched.
+    template <typename Change>
+    void Write(Change change);
+    void WaitForReaders();
+
+    std::array<SearchServer, 2> instances_;
+    std::array<uint64_t, 2> instance_versions_ = {};
+    std::atomic<int> read_index_ = 0;
+    std::atomic<int> epoch_ = 0;
+    mutable std::array<ReadIndicator, 2> read_indicators_;
+    std::mutex write_mutex_;
+    uint64_t version_ = 0;
+};
+
+template <typename StringContainer>
+VersionedSearchServer::VersionedSearchServer(const StringContainer& stop_words, TermFreqStorage term_freq_storage, IndexHugePages huge_pages)
+    : instances_{ SearchServer(stop_words, term_freq_storage, huge_pages), SearchServer(stop_words, term_freq_storage, huge_pages) } {
+}
+
+template <typename Change>
+void VersionedSearchServer::Write(Change change) {
+    std::lock_guard guard(write_mutex_);
+    const int read_index = read_index_.load();
+    const int write_index = 1 - read_index;
+    change(instances_[write_index]);
+    instance_versions_[write_index] = ++version_;
+    read_index_.store(write_index);
+    WaitForReaders();
+    change(instances_[read_index]);
+    instance_versions_[read_index] = version_;
+}
\ No newline at end of file
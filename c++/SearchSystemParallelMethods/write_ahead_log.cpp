@@ -0,0 +1,277 @@
+#include "write_ahead_log.h"
+
+#include "file_sync.h"
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std::literals;
+
+namespace {
+
+uint32_t ComputeCrc32(const char* data, size_t size) {
+    static const auto table = [] {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1) != 0 ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+            }
+            table[i] = crc;
+        }
+        return table;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+template <typename T>
+void Put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Reads a T at position and advances it; false if the data ends first.
+template <typename T>
+bool Get(std::string_view data, size_t& position, size_t end, T& value) {
+    if (end - position < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, data.data() + position, sizeof(T));
+    position += sizeof(T);
+    return true;
+}
+
+// A frame is the payload size, the payload's CRC-32 and the payload.
+constexpr size_t FRAME_HEADER_SIZE = 2 * sizeof(uint32_t);
+
+} // namespace
+
+std::string EncodeWalRecord(const WalRecord& record) {
+    std::string payload;
+    Put(payload, static_cast<uint8_t>(record.type));
+    Put(payload, static_cast<int32_t>(record.document_id));
+    Put(payload, static_cast<int32_t>(record.status));
+    Put(payload, static_cast<uint32_t>(record.ratings.size()));
+    for (const int rating : record.ratings) {
+        Put(payload, static_cast<int32_t>(rating));
+    }
+    Put(payload, static_cast<uint32_t>(record.text.size()));
+    payload += record.text;
+    return payload;
+}
+
+bool DecodeWalRecord(std::string_view data, WalRecord& record) {
+    size_t position = 0;
+    const size_t end = data.size();
+    uint8_t type;
+    int32_t document_id;
+    int32_t status;
+    uint32_t rating_count;
+    if (!Get(data, position, end, type) || !Get(data, position, end, document_id) || !Get(data, position, end, status)
+        || !Get(data, position, end, rating_count) || type > static_cast<uint8_t>(WalRecord::Type::REMOVE_DOCUMENT)
+        || rating_count > (end - position) / sizeof(int32_t)) {
+        return false;
+    }
+    record.type = static_cast<WalRecord::Type>(type);
+    record.document_id = document_id;
+    record.status = static_cast<DocumentStatus>(status);
+    record.ratings.resize(rating_count);
+    for (int& rating : record.ratings) {
+        int32_t value;
+        if (!Get(data, position, end, value)) {
+            return false;
+        }
+        rating = value;
+    }
+    uint32_t text_size;
+    if (!Get(data, position, end, text_size) || text_size != end - position) {
+        return false;
+    }
+    record.text.assign(data.substr(position, text_size));
+    return true;
+}
+
+WriteAheadLog::WriteAheadLog(const std::string& path, WalOptions options)
+    : path_(path)
+    , options_(options)
+    , fd_(open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)) {
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot open write-ahead log "s + path);
+    }
+    // A record synced into a file whose name is not is lost all the same, so the directory
+    // entry is made durable before any Commit can return.
+    try {
+        SyncParentDirectory(path);
+    }
+    catch (const std::runtime_error&) {
+        close(fd_);
+        throw;
+    }
+    if (options_.sync_policy == WalSyncPolicy::INTERVAL) {
+        syncer_ = std::thread([this] {
+            RunSyncer();
+            });
+    }
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    syncer_wake_up_.notify_all();
+    if (syncer_.joinable()) {
+        syncer_.join();
+    }
+    try {
+        Flush();
+    }
+    catch (const std::runtime_error&) {
+    }
+    close(fd_);
+}
+
+uint64_t WriteAheadLog::Append(const WalRecord& record) {
+    const std::string payload = EncodeWalRecord(record);
+
+    std::lock_guard lock(mutex_);
+    Put(buffer_, static_cast<uint32_t>(payload.size()));
+    Put(buffer_, ComputeCrc32(payload.data(), payload.size()));
+    buffer_ += payload;
+    return ++appended_sequence_;
+}
+
+void WriteAheadLog::Commit(uint64_t sequence) {
+    if (options_.sync_policy == WalSyncPolicy::INTERVAL) {
+        return;
+    }
+    const bool sync = options_.sync_policy == WalSyncPolicy::EVERY_OPERATION;
+    std::unique_lock lock(mutex_);
+    while ((sync ? synced_sequence_ : written_sequence_) < sequence) {
+        if (failed_) {
+            throw std::runtime_error("Cannot write write-ahead log "s + path_);
+        }
+        if (writing_) {
+            written_.wait(lock);
+        }
+        else {
+            WriteBuffered(lock, sync);
+        }
+    }
+}
+
+void WriteAheadLog::Flush() {
+    std::unique_lock lock(mutex_);
+    const uint64_t sequence = appended_sequence_;
+    while (synced_sequence_ < sequence) {
+        if (failed_) {
+            throw std::runtime_error("Cannot write write-ahead log "s + path_);
+        }
+        if (writing_) {
+            written_.wait(lock);
+        }
+        else {
+            WriteBuffered(lock, true);
+        }
+    }
+}
+
+WalStats WriteAheadLog::GetStats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+WalReplayResult WriteAheadLog::Replay(const std::string& path, const std::function<void(const WalRecord&)>& apply) {
+    WalReplayResult result;
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return result;
+    }
+    const std::string data{ std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+    in.close();
+
+    size_t position = 0;
+    WalRecord record;
+    while (position < data.size()) {
+        size_t payload_position = position;
+        uint32_t payload_size;
+        uint32_t crc;
+        if (!Get(data, payload_position, data.size(), payload_size) || !Get(data, payload_position, data.size(), crc)
+            || payload_size > data.size() - payload_position || ComputeCrc32(data.data() + payload_position, payload_size) != crc
+            || !DecodeWalRecord(std::string_view(data).substr(payload_position, payload_size), record)) {
+            break;
+        }
+        apply(record);
+        ++result.record_count;
+        position = payload_position + payload_size;
+    }
+    if (position < data.size()) {
+        std::filesystem::resize_file(path, position);
+        SyncPath(path);
+        result.truncated = true;
+    }
+    return result;
+}
+
+void WriteAheadLog::WriteBuffered(std::unique_lock<std::mutex>& lock, bool sync) {
+    writing_ = true;
+    write_buffer_.swap(buffer_);
+    const uint64_t batch_end = appended_sequence_;
+    lock.unlock();
+
+    bool written = true;
+    for (size_t position = 0; position < write_buffer_.size();) {
+        const ssize_t size = write(fd_, write_buffer_.data() + position, write_buffer_.size() - position);
+        if (size < 0) {
+            written = false;
+            break;
+        }
+        position += size;
+    }
+    const bool synced = written && sync && fdatasync(fd_) == 0;
+
+    lock.lock();
+    writing_ = false;
+    if (written && (synced || !sync)) {
+        stats_.record_count += batch_end - written_sequence_;
+        stats_.byte_count += write_buffer_.size();
+        stats_.write_count += write_buffer_.empty() ? 0 : 1;
+        stats_.sync_count += synced ? 1 : 0;
+        written_sequence_ = batch_end;
+        synced_sequence_ = synced ? batch_end : synced_sequence_;
+    }
+    else {
+        failed_ = true;
+    }
+    write_buffer_.clear();
+    written_.notify_all();
+    if (failed_) {
+        throw std::runtime_error("Cannot write write-ahead log "s + path_);
+    }
+}
+
+void WriteAheadLog::RunSyncer() {
+    std::unique_lock lock(mutex_);
+    while (!stopping_ && !failed_) {
+        syncer_wake_up_.wait_for(lock, options_.sync_interval, [this] {
+            return stopping_;
+            });
+        if (!writing_ && synced_sequence_ < appended_sequence_) {
+            try {
+                WriteBuffered(lock, true);
+            }
+            catch (const std::runtime_error&) {
+            }
+        }
+    }
+}
\ No newline at end of file
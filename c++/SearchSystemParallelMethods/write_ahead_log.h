@@ -0,0 +1,114 @@
+#pragma once
+
+#include "document.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// When WriteAheadLog::Commit returns, and what a crash can take with it.
+//   EVERY_OPERATION - after the record is written and fdatasync'ed: nothing is lost.
+//   INTERVAL        - at once; a background thread writes and syncs every sync_interval,
+//                     so a crash loses up to that much of the latest changes.
+//   NEVER           - after the record is written to the file, never synced: a process crash
+//                     loses nothing, an OS crash or power loss whatever the page cache held.
+enum class WalSyncPolicy {
+    EVERY_OPERATION,
+    INTERVAL,
+    NEVER,
+};
+
+struct WalOptions {
+    WalSyncPolicy sync_policy = WalSyncPolicy::EVERY_OPERATION;
+    std::chrono::milliseconds sync_interval{ 10 };
+};
+
+struct WalRecord {
+    enum class Type : uint8_t {
+        ADD_DOCUMENT,
+        REMOVE_DOCUMENT,
+    };
+
+    Type type = Type::ADD_DOCUMENT;
+    int document_id = 0;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+    std::string text;
+};
+
+// The record's payload inside a log frame; LogShipper sends the same encoding. Decoding
+// returns false for data that is not exactly one record.
+std::string EncodeWalRecord(const WalRecord& record);
+bool DecodeWalRecord(std::string_view data, WalRecord& record);
+
+// record_count / write_count is how many records a group commit wrote at once on average.
+struct WalStats {
+    uint64_t record_count = 0;
+    uint64_t byte_count = 0;
+    uint64_t write_count = 0;
+    uint64_t sync_count = 0;
+};
+
+struct WalReplayResult {
+    size_t record_count = 0;
+    // The file ended in a partly written or corrupt record, which was cut off.
+    bool truncated = false;
+};
+
+// Append-only log of index changes. A record is framed by its length and CRC-32, so replay
+// stops at the first record a crash left incomplete. Appending only buffers the record;
+// Commit makes it durable with group commit: the first committer writes and syncs every
+// buffered record in one go while later committers wait, and each of them returns as soon
+// as a write covering its record is done. Thread-safe.
+class WriteAheadLog {
+public:
+    // Appends to the file at path, creating it if needed.
+    WriteAheadLog(const std::string& path, WalOptions options = {});
+    // Writes and syncs whatever is still buffered.
+    ~WriteAheadLog();
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Returns the record's sequence number, counted from 1 for this object.
+    uint64_t Append(const WalRecord& record);
+    // Returns when record sequence is as durable as the sync policy promises.
+    void Commit(uint64_t sequence);
+    // Writes and syncs every appended record, whatever the policy.
+    void Flush();
+
+    WalStats GetStats() const;
+
+    // Calls apply for every intact record of the file in order and cuts off a torn tail, so
+    // that a WriteAheadLog opened on the file afterwards appends after the last intact record.
+    static WalReplayResult Replay(const std::string& path, const std::function<void(const WalRecord&)>& apply);
+
+private:
+    // Writes the buffered records as the group's leader; called with lock held, returns with it held.
+    void WriteBuffered(std::unique_lock<std::mutex>& lock, bool sync);
+    void RunSyncer();
+
+    const std::string path_;
+    const WalOptions options_;
+    int fd_ = -1;
+
+    mutable std::mutex mutex_;
+    std::condition_variable written_;
+    std::condition_variable syncer_wake_up_;
+    std::string buffer_;
+    std::string write_buffer_;
+    uint64_t appended_sequence_ = 0;
+    uint64_t written_sequence_ = 0;
+    uint64_t synced_sequence_ = 0;
+    bool writing_ = false;
+    // A write failed; its records are lost, so every later Commit and Flush throws.
+    bool failed_ = false;
+    bool stopping_ = false;
+    WalStats stats_;
+    std::thread syncer_;
+};
\ No newline at end of file